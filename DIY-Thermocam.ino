@@ -33,6 +33,8 @@
 #include <Touchscreen.h>
 #include <Camera.h>
 #include <Metro.h>
+#include <RawCodec.h>
+#include <QOICodec.h>
 
 /* General Includes */
 
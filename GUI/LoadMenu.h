@@ -31,7 +31,7 @@ void displayGUI(int imgCount, char* infoText) {
 		display.print((char*) "<", 10, 110);
 		display.print((char*) ">", 295, 110);
 	}
-	//Convert image to bitmap
+	//Convert image to QOI or video to bitmaps
 	display.print((char*) "Convert", 5, 210);
 	//Exit to main menu
 	display.print((char*) "Exit", 250, 210);
@@ -65,26 +65,23 @@ void deleteVideo(char* dirname) {
 			//YES
 			if (pressedButton == 0) {
 				showFullMessage((char*) "Delete video..");
+				//Number of frames from the container or the single files
+				uint16_t frames = getVideoFrameNumber(dirname);
 				//Start SD
 				startAltClockline(true);
 				//Go into the video folder
 				sd.chdir("/");
 				sd.chdir(dirname);
-				//Delete all files
-				uint16_t videoCounter = 0;
-				bool exists;
+				//Remove the video container
+				if (sd.exists(video_fileName))
+					sd.remove(video_fileName);
 				char filename[] = "00000.DAT";
 				//Go through the frames
-				while (1) {
+				for (uint16_t videoCounter = 0; videoCounter < frames; videoCounter++) {
 					//Get the frame name
 					frameFilename(filename, videoCounter);
-					//Check frame existance
-					exists = sd.exists(filename);
-					//If the frame does not exists, end remove
-					if (!exists)
-						break;
-					//Otherwise remove file
-					else
+					//Remove the raw frame if there
+					if (sd.exists(filename))
 						sd.remove(filename);
 					//Remove Bitmap if there
 					strcpy(&filename[5], ".BMP");
@@ -96,13 +93,13 @@ void deleteVideo(char* dirname) {
 						sd.remove(filename);
 					//Reset ending
 					strcpy(&filename[5], ".DAT");
-					//Raise counter
-					videoCounter++;
 				}
 				//Switch back to the root
 				sd.chdir("/");
 				//Remove the folder itself
 				sd.rmdir(dirname);
+				//Remove it from the catalog
+				catalogRemove(dirname);
 				//End SD
 				endAltClockline();
 				showFullMessage((char*) "Video deleted!");
@@ -154,6 +151,12 @@ void deleteImage(char* filename) {
 				strcpy(&filename[14], ".BMP");
 				if ((convertEnabled == 1) && (sd.exists(filename)))
 					sd.remove(filename);
+				//Delete .QOI file, also created by a later conversion
+				strcpy(&filename[14], ".QOI");
+				if (sd.exists(filename))
+					sd.remove(filename);
+				//Remove it from the catalog
+				catalogRemove(filename);
 				endAltClockline();
 				showFullMessage((char*) "Image deleted!");
 				delay(1000);
@@ -176,7 +179,7 @@ bool convertPrompt() {
 	display.setBackColor(200, 200, 200);
 	display.print((char*)"Do you want to convert ?", CENTER, 66);
 	display.print((char*)"That process will create", CENTER, 105);
-	display.print((char*)"bitmap(s) out of the raw data.", CENTER, 125);
+	display.print((char*)"image file(s) out of the raw data.", CENTER, 125);
 	//Draw the buttons
 	touchButtons.deleteAllButtons();
 	touchButtons.setTextFont(bigFont);
@@ -203,11 +206,11 @@ bool convertPrompt() {
 	}
 }
 
-/* Convert a raw image lately to BMP */
+/* Convert a raw image lately to QOI */
 void convertImage(char* filename) {
 
-	//Check if image is a bitmap
-	if (filename[15] == 'B') {
+	//Check if image is a bitmap or QOI
+	if ((filename[15] == 'B') || (filename[15] == 'Q')) {
 		showFullMessage((char*) "Image is already converted!");
 		delay(500);
 		return;
@@ -217,6 +220,8 @@ void convertImage(char* filename) {
 	strcpy(&filename[14], ".BMP");
 	startAltClockline(true);
 	bool exists = sd.exists(filename);
+	strcpy(&filename[14], ".QOI");
+	exists |= sd.exists(filename);
 	endAltClockline();
 
 	//If image is already converted, return
@@ -234,7 +239,7 @@ void convertImage(char* filename) {
 	}
 
 	//Show convert message
-	showFullMessage((char*) "Converting image to BMP..");
+	showFullMessage((char*) "Converting image to QOI..");
 	delay(500);
 
 	//Display on screen
@@ -258,9 +263,12 @@ void convertVideo(char* dirname) {
 	//Go into the folder
 	sd.chdir(dirname);
 
-	//Get the frame name of the first frame
-	frameFilename(filename, 0);
-	bool exists = sd.exists(filename);
+	//Get the frame name of the last frame, an aborted conversion is continued
+	bool exists = false;
+	if (frames > 0) {
+		frameFilename(filename, frames - 1);
+		exists = sd.exists(filename);
+	}
 	endAltClockline();
 
 	//If video is already converted, return
@@ -300,6 +308,11 @@ void openImage(char* filename, int imgCount) {
 		loadBMPImage(filename);
 	}
 
+	//Load QOI image
+	else if (filename[15] == 'Q') {
+		loadQOIImage(filename);
+	}
+
 	//Unsupported file type
 	else {
 		showFullMessage((char*) "Unsupported file type!");
@@ -339,13 +352,22 @@ void openImage(char* filename, int imgCount) {
 /* Get the number of frames in the video */
 uint16_t getVideoFrameNumber(char* dirname) {
 	uint16_t videoCounter = 0;
-	bool exists;
+	uint32_t frames, stride;
+	bool exists, lepton3;
 	char filename[] = "00000.DAT";
 	//Switch Clock to Alternative
 	startAltClockline(true);
 	//Go into the folder
 	sd.chdir(dirname);
-	//Look how many frames we have
+	//Video container, take the number from the header
+	if (sdFile.open(video_fileName, O_READ)) {
+		if (readVideoHeader(&frames, &stride, &lepton3))
+			videoCounter = frames;
+		sdFile.close();
+		endAltClockline();
+		return videoCounter;
+	}
+	//Otherwise look how many frames we have
 	while (true) {
 		//Get the frame name
 		frameFilename(filename, videoCounter);
@@ -367,46 +389,71 @@ uint16_t getVideoFrameNumber(char* dirname) {
 void playVideo(char* dirname, int imgCount) {
 	//Help variables
 	uint16_t numberOfFrames = getVideoFrameNumber(dirname);
-	char filename[] = "00000.DAT";
 	char buffer[14];
+	uint32_t frames, stride, frameDue;
+	uint32_t playStart = 0;
+	uint32_t frameTime = 0, firstTime = 0;
+	uint16_t interval = 0;
+	bool lepton3;
+
+	//Keep the container open, following frames come from the read-ahead buffer
+	startAltClockline();
+	sd.chdir("/");
+	sd.chdir(dirname);
+	bool container = sdFile.open(video_fileName, O_READ);
+	if ((container) && (!readVideoHeader(&frames, &stride, &lepton3, &interval))) {
+		sdFile.close();
+		container = false;
+	}
+	endAltClockline();
 
-	//Play forever
-	while (true) {
+	//Play until the screen is touched
+	while ((numberOfFrames != 0) && (loadTouch == loadTouch_none)) {
 		//Go through the frames
 		for (int i = 0; i < numberOfFrames; i++) {
-			//Check for touch press
-			if (touch.touched())
-				loadTouchIRQ();
-			if (loadTouch != loadTouch_none)
-				return;
-
-			//Get the frame name
-			frameFilename(filename, i);
-
 			//Load Raw data
-			loadRawData(filename, dirname);
+			if (container) {
+				startAltClockline();
+				frameTime = readVideoFrame(i, stride, lepton3);
+				endAltClockline();
+			}
+			else
+				loadVideoFrame(dirname, i);
 
-			//Check for touch press
-			if (touch.touched())
-				loadTouchIRQ();
+			//Recorded videos keep the time between their frames, time-lapse and single frames a fixed rate
+			if (i == 0) {
+				playStart = millis();
+				firstTime = frameTime;
+			}
+			if ((container) && (interval == 0))
+				frameDue = frameTime - firstTime;
+			else
+				frameDue = (i * 1000UL) / video_playbackFPS;
+
+			//Wait until the frame is due, check for touch press
+			do {
+				if (touch.touched())
+					loadTouchIRQ();
+			} while ((loadTouch == loadTouch_none) && ((millis() - playStart) < frameDue));
 			if (loadTouch != loadTouch_none)
-				return;
+				break;
 
 			//Display Raw Data
 			displayRawData();
 
-			//Check for touch press
-			if (touch.touched())
-				loadTouchIRQ();
-			if (loadTouch != loadTouch_none)
-				return;
-
 			//Create string
 			sprintf(buffer, "%5d / %-5d", i + 1, numberOfFrames);
 			//Display GUI
 			displayGUI(imgCount, buffer);
 		}
 	}
+
+	//Close the container
+	if (container) {
+		startAltClockline();
+		sdFile.close();
+		endAltClockline();
+	}
 }
 
 /* Shows a menu where the user can choose the time & date items for the image */
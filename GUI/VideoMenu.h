@@ -270,8 +270,9 @@ void videoCapture() {
 	//Update display
 	showFullMessage((char*) "Please wait..");
 
-	//Create folder 
+	//Create folder and the container for the frames
 	createVideoFolder(dirname);
+	createVideoFile(dirname);
 
 	//Set text colors
 	setTextColor();
@@ -318,6 +319,9 @@ void videoCapture() {
 		}
 	}
 
+	//Add the index to the container and close it
+	closeVideoFile(dirname, framesCaptured);
+
 	//Turn the display on if it was off before
 	if (!checkScreenLight())
 		enableScreenLight();
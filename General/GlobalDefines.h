@@ -50,6 +50,10 @@
 #define leptonVersion_3_Shutter   1 //FLIR Lepton3 Shuttered
 #define leptonVersion_2_NoShutter 2 //FLIR Lepton2 Non-Shuttered
 
+//FLIR Lepton VoSPI
+#define lepton_syncTimeout 200 //Resync after this time in ms without a valid line
+#define lepton_resetDelay  186 //Time in ms with CS high to resync the VoSPI
+
 //Temperature format
 #define tempFormat_celcius    0
 #define tempFormat_fahrenheit 1
@@ -220,6 +224,15 @@
 #define videoSave_recording  2
 #define videoSave_processing 3
 
+//Video container
+#define video_fileName       "VIDEO.VID"
+#define video_magic          "TCV1"
+#define video_headerSize     512  //Header sector in front of the frames
+#define video_frameHeader    4    //Timestamp in front of every frame
+#define video_preallocFrames 1024 //Frames allocated as one contiguous block
+#define video_syncFrames     32   //Interval to update the frame number in the header
+#define video_playbackFPS    9    //Playback rate of time-lapse videos and single frames
+
 //Load touch decision marker
 #define loadTouch_none     0
 #define loadTouch_find     1
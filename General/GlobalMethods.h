@@ -34,9 +34,15 @@ void timeAndDateMenu(bool firstStart = false);
 void saveRawData(bool image, char* name, uint16_t framesCaptured = 0);
 void proccessVideoFrames(uint16_t framesCaptured, char* dirname);
 void createVideoFolder(char* dirname);
+void createVideoFile(char* dirname);
+void catalogAdd(char* name, byte type, uint32_t size, uint16_t frames = 0);
+void catalogRemove(char* name);
+void catalogInvalidate();
+void closeVideoFile(char* dirname, uint16_t framesCaptured);
 void boxFilter();
 void gaussianFilter();
 void convertColors();
+void convertIndices();
 void bootScreen();
 void storageMenu();
 void checkWarmup();
@@ -47,6 +53,9 @@ void frameFilename(char* filename, uint16_t count);
 void liveMode();
 void load();
 void loadRawData(char* filename, char* dirname = NULL);
+void loadVideoFrame(char* dirname, uint16_t frame);
+bool readVideoHeader(uint32_t* frames, uint32_t* stride, bool* lepton3, uint16_t* interval = NULL);
+uint32_t readVideoFrame(uint32_t frame, uint32_t stride, bool lepton3);
 void settingsMenuHandler();
 void saveDisplayImage(char* filename, char* dirname = NULL);
 uint16_t getVideoFrameNumber(char* dirname);
@@ -85,9 +94,12 @@ void compensateCalib();
 void touchIRQ();
 void displayRawData();
 void loadBMPImage(char* filename);
+void loadQOIImage(char* filename);
 void loadTouchIRQ();
 void drawTitle(char* name, bool firstStart = false);
 void checkImageSave();
 void saveScreenshot();
 void createSDName(char* filename, bool folder = false);
-void toggleLaser(bool message = false);
\ No newline at end of file
+void toggleLaser(bool message = false);
+void benchmarkPipeline();
+void benchmarkSDCard();
\ No newline at end of file
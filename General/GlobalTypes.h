@@ -0,0 +1,31 @@
+/*
+*
+* GLOBAL TYPES - Global structures, that are used firmware-wide
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+/* Types */
+
+//Statistics of the last frame from the Lepton, calculated once per frame
+struct FrameStats {
+	uint16_t min;
+	uint16_t max;
+	uint16_t minPos;
+	uint16_t maxPos;
+	uint16_t average;
+	uint16_t histogram[64];
+	//Spot and ambient temperature of the MLX90614 for the frame
+	float spot;
+	float ambient;
+	//Time of the capture in milliseconds
+	uint32_t time;
+};
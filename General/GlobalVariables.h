@@ -14,6 +14,7 @@
 */
 
 #include "GlobalDefines.h"
+#include "GlobalTypes.h"
 
 /* Variables */
 
@@ -40,6 +41,10 @@ extern uint8_t bigFont[];
 SdFat sd;
 SdFile sdFile;
 String sdInfo;
+//Lossless codec for the raw frames
+RawCodec rawCodec;
+//Lossless codec for the converted images
+QOICodec qoiCodec;
 //Camera
 Camera cam(&Serial1);
 
@@ -49,9 +54,16 @@ byte colorScheme;
 const byte *colorMap;
 //Number of rgb elements inside the color scheme
 int16_t colorElements;
+//RGB565 lookup table for the color scheme, hot / cold color as last entry
+uint16_t colorLUT[256];
+//Number of entries inside the lookup table
+uint16_t colorLUTCount;
 
-//160x120 image storage
-unsigned short image[19200];
+//160x120 image storage, word aligned for pixel pair access
+unsigned short image[19200] __attribute__((aligned(4)));
+//Lepton2 raw data is stored as 80x60 until the colors are converted
+bool imageNative = false;
+//DMA settings for the display transfer
 DMASetting dmasettings[3];
 //Array to store the printed temperatures
 uint16_t showTemp[192];
@@ -82,6 +94,8 @@ uint16_t minTemp;
 //Position of min and maxtemp
 uint16_t minTempPos;
 uint16_t maxTempPos;
+//Statistics of the last frame from the Lepton, calculated once per frame
+FrameStats frameStats;
 //Hot / Cold mode
 byte hotColdMode;
 int16_t hotColdLevel;
@@ -206,6 +206,8 @@ void getVisualImage() {
 	//End transmission
 	cam.end();
 
+	//The image buffer gets the 160x120 colors, no native Lepton2 frame any more
+	imageNative = false;
 	//Decompress the image
 	iodev.jpic = jpegData;
 	iodev.jsize = jpglen;
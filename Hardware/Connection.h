@@ -40,20 +40,27 @@
 #define CMD_MINMAXPOS     127 
 #define CMD_VISUALIMGHIGH 128
 #define CMD_FWVERSION     129
+#define CMD_BENCHMARK     130
+#define CMD_SDBENCHMARK   131
 
 //Serial frame commands
 #define CMD_RAWFRAME      150
 #define CMD_COLORFRAME    151
-//Types of frame responses
-#define FRAME_CAPTURE     180
-#define FRAME_STARTVID    181
-#define FRAME_STOPVID     182
-#define FRAME_NORMAL      183
+
+//Protocol version 2 commands, followed by the frame format
+#define CMD_FRAMEV2       152
+#define CMD_STREAMSTART   153
+#define CMD_STREAMSTOP    154
+//Region of interest and decimation of the v2 raw frames
+#define CMD_SETROI        155
+//Statistics of the last frame
+#define CMD_FRAMESTATS    156
 
 /* Variables */
 
-//Command, default send frame
-byte sendCmd = FRAME_NORMAL;
+//Push a v2 frame after every capture and its format
+bool streamEnabled = false;
+byte streamFormat = frameFormat_raw;
 
 /* Methods */
 
@@ -85,27 +92,36 @@ void sendRawLimits() {
 	Serial.write(maxTemp & 0x00FF);
 }
 
+/* Send 16 bit values MSB first, collected into bulk writes */
+void sendWords(uint16_t* values, uint16_t count, byte step = 1) {
+	byte buffer[320];
+	uint16_t pos = 0;
+	for (uint16_t i = 0; i < count; i++) {
+		uint16_t value = values[i * step];
+		buffer[pos++] = (value & 0xFF00) >> 8;
+		buffer[pos++] = value & 0x00FF;
+		if (pos == sizeof(buffer)) {
+			Serial.write(buffer, pos);
+			pos = 0;
+		}
+	}
+	if (pos != 0)
+		Serial.write(buffer, pos);
+}
+
 /* Send the lepton raw data*/
 void sendRawData(bool color = false) {
-	uint16_t result;
-
+	//For the Lepton2 sensor in the native size, write 4800 raw values
+	if ((imageNative) && (!color))
+		sendWords(image, 4800);
 	//For the Lepton2 sensor, write 4800 raw values
-	if ((leptonVersion != leptonVersion_3_Shutter) && (!color)) {
-		for (int line = 0; line < 60; line++) {
-			for (int column = 0; column < 80; column++) {
-				result = image[(line * 2 * 160) + (column * 2)];
-				Serial.write((result & 0xFF00) >> 8);
-				Serial.write(result & 0x00FF);
-			}
-		}
+	else if ((leptonVersion != leptonVersion_3_Shutter) && (!color)) {
+		for (int line = 0; line < 60; line++)
+			sendWords(&image[line * 2 * 160], 80, 2);
 	}
 	//For the Lepton3 sensor, write 19200 raw values
-	else {
-		for (int i = 0; i < 19200; i++) {
-			Serial.write((image[i] & 0xFF00) >> 8);
-			Serial.write(image[i] & 0x00FF);
-		}
-	}
+	else
+		sendWords(image, 19200);
 }
 
 /* Sends the configuration data */
@@ -145,20 +161,17 @@ void sendCalibrationData() {
 	uint8_t farray[4];
 	//Send the calibration offset first
 	floatToBytes(farray, (float)calOffset);
-	for (int i = 0; i < 4; i++)
-		Serial.write(farray[i]);
+	Serial.write(farray, 4);
 	//Send the calibration slope
 	floatToBytes(farray, (float)calSlope);
-	for (int i = 0; i < 4; i++)
-		Serial.write(farray[i]);
+	Serial.write(farray, 4);
 }
 
 /* Sends the spot temp*/
 void sendSpotTemp() {
 	uint8_t farray[4];
-	floatToBytes(farray, mlx90614Temp);
-	for (int i = 0; i < 4; i++)
-		Serial.write(farray[i]);
+	floatToBytes(farray, frameStats.spot);
+	Serial.write(farray, 4);
 }
 
 /* Change the color scheme */
@@ -213,10 +226,7 @@ void setCalSlope() {
 
 /* Send the temperature points */
 void sendTempPoints() {
-	for (int i = 0; i < 192; i++) {
-		Serial.write((showTemp[i] & 0xFF00) >> 8);
-		Serial.write(showTemp[i] & 0x00FF);
-	}
+	sendWords(showTemp, 192);
 }
 
 /* Send the laser state */
@@ -237,13 +247,9 @@ void sendBatteryStatus() {
 /* Sends the position of the min/max value */
 void sendMinMaxPos() {
 	uint16_t minXPos, minYPos, maxXPos, maxYPos;
-	//Get raw temperatures
-	getTemperatures();
-	//Find min and max value
-	findMinMaxPositions();
-	//Calculate their position
-	calculateMinMaxPoint(&minXPos, &minYPos, minTempPos);
-	calculateMinMaxPoint(&maxXPos, &maxYPos, maxTempPos);
+	//Calculate their position from the statistics of the last frame
+	calculateMinMaxPoint(&minXPos, &minYPos, frameStats.minPos);
+	calculateMinMaxPoint(&maxXPos, &maxYPos, frameStats.maxPos);
 	//Minimum temp x position
 	Serial.write(minXPos);
 	//Minimum temp y position
@@ -254,6 +260,25 @@ void sendMinMaxPos() {
 	Serial.write(maxYPos);
 }
 
+/* Sends the statistics of the last frame */
+void sendFrameStats() {
+	uint8_t farray[4];
+	//Min, max, their positions and the center average
+	uint16_t values[5] = { frameStats.min, frameStats.max,
+		frameStats.minPos, frameStats.maxPos, frameStats.average };
+	sendWords(values, 5);
+	//Spot and ambient temperature
+	floatToBytes(farray, frameStats.spot);
+	Serial.write(farray, 4);
+	floatToBytes(farray, frameStats.ambient);
+	Serial.write(farray, 4);
+	//Capture time in milliseconds
+	Serial.write((frameStats.time >> 24) & 0xFF);
+	Serial.write((frameStats.time >> 16) & 0xFF);
+	Serial.write((frameStats.time >> 8) & 0xFF);
+	Serial.write(frameStats.time & 0xFF);
+}
+
 /* Send the current firmware version */
 void sendFWVersion() {
 	Serial.write(fwVersion);
@@ -293,6 +318,39 @@ void sendFrame(bool color) {
 		sendCmd = FRAME_NORMAL;
 }
 
+/* Sets the region of interest and the decimation of the v2 raw frames */
+void setROI() {
+	//Wait for x, y, width, height and decimation, maximum 1 second
+	uint32_t timer = millis();
+	while ((Serial.available() < 5) && ((millis() - timer) < 1000));
+	if (Serial.available() < 5)
+		return;
+	roiX = Serial.read();
+	roiY = Serial.read();
+	roiWidth = Serial.read();
+	roiHeight = Serial.read();
+	roiStep = Serial.read();
+	if (roiStep == 0)
+		roiStep = 1;
+	else if (roiStep > 16)
+		roiStep = 16;
+	//Start the compressed frames with a keyframe
+	deltaValid = false;
+}
+
+/* Reads the frame format behind a v2 command, maximum 1 second */
+byte readFrameFormat() {
+	uint32_t timer = millis();
+	while (!Serial.available() && ((millis() - timer) < 1000));
+	//Raw frames if no valid format was sent
+	if (Serial.available() == 0)
+		return frameFormat_raw;
+	byte format = Serial.read();
+	if (format >= frameFormat_total)
+		return frameFormat_raw;
+	return format;
+}
+
 /* Evaluates commands from the serial port*/
 bool serialHandler() {
 	//Read command from Serial Port
@@ -396,6 +454,14 @@ bool serialHandler() {
 	case CMD_FWVERSION:
 		sendFWVersion();
 		break;
+		//Run the frame pipeline benchmark
+	case CMD_BENCHMARK:
+		benchmarkPipeline();
+		break;
+		//Run the SD card benchmark
+	case CMD_SDBENCHMARK:
+		benchmarkSDCard();
+		break;
 		//Send raw frame
 	case CMD_RAWFRAME:
 		sendFrame(false);
@@ -404,6 +470,36 @@ bool serialHandler() {
 	case CMD_COLORFRAME:
 		sendFrame(true);
 		break;
+		//Send frame of the protocol version 2
+	case CMD_FRAMEV2:
+		sendFrameV2(readFrameFormat());
+		break;
+		//Start to push v2 frames
+	case CMD_STREAMSTART:
+		streamFormat = readFrameFormat();
+		streamEnabled = true;
+		//Start with palette and keyframe
+		paletteSent = false;
+		deltaValid = false;
+		//Send ACK
+		Serial.write(CMD_STREAMSTART);
+		break;
+		//Set region of interest and decimation
+	case CMD_SETROI:
+		setROI();
+		//Send ACK
+		Serial.write(CMD_SETROI);
+		break;
+		//Send statistics of the last frame
+	case CMD_FRAMESTATS:
+		sendFrameStats();
+		break;
+		//Stop to push v2 frames
+	case CMD_STREAMSTOP:
+		streamEnabled = false;
+		//Send ACK
+		Serial.write(CMD_STREAMSTOP);
+		break;
 		//End connection
 	case CMD_END:
 		return true;
@@ -467,6 +563,10 @@ void serialOutput() {
 		if (extButtonPressed())
 			buttonHandler();
 
+		//Push the frame in streaming mode
+		if (streamEnabled)
+			sendFrameV2(streamFormat);
+
 		//Check for serial commands
 		if (Serial.available() > 0) {
 			//Check for exit
@@ -495,6 +595,13 @@ void serialConnect() {
 
 	//Send ACK for Start
 	Serial.write(CMD_START);
+	//New viewer, send the palette and a keyframe first
+	paletteSent = false;
+	deltaValid = false;
+	//Full frame without decimation
+	roiWidth = 0;
+	roiHeight = 0;
+	roiStep = 1;
 
 	//Go to the serial output
 	serialOutput();
@@ -530,4 +637,7 @@ void serialConnect() {
 
 	//Disable video mode
 	videoSave = videoSave_disabled;
+
+	//Disable streaming for the next connection
+	streamEnabled = false;
 }
\ No newline at end of file
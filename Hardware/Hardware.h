@@ -17,8 +17,10 @@
 #include "Battery.h"
 #include "Cam.h"
 #include "MLX90614.h"
+#include "LeptonCRC.h"
 #include "Lepton.h"
 #include "SD.h"
+#include "SerialFrame.h"
 #include "Connection.h"
 #include "MassStorage.h"
 
@@ -309,6 +311,8 @@ void initDisplay() {
 	setDisplayRotation();
 	//Link display library to image array
 	display.imagePtr = image;
+	//Write the screen content with DMA
+	display.dmaSettings = dmasettings;
 
 	//If returning from mass storage, do not check
 	if (EEPROM.read(eeprom_massStorage) == eeprom_setValue) {
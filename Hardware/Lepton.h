@@ -14,8 +14,24 @@
 */
 
 /* Variables */
-//Array to store one Lepton frame
-byte leptonFrame[164];
+//Two buffers for the Lepton packets, one is received while the other is stored
+byte leptonBuffer[2][164];
+//Points to the packet that has been received last
+byte* leptonFrame = leptonBuffer[0];
+//Index of the buffer that receives the next packet
+byte leptonBufferIndex = 0;
+//Packet reception in the background running
+volatile bool leptonPacketPending = false;
+//DMA channels for the packet reception
+DMAChannel leptonDMATX;
+DMAChannel leptonDMARX;
+//Dummy byte clocked out to the Lepton
+const byte leptonDummy = 0;
+//VoSPI statistics
+uint32_t leptonDiscards = 0;
+uint32_t leptonSyncLosses = 0;
+uint32_t leptonResets = 0;
+uint32_t leptonCRCErrors = 0;
 
 /* Methods */
 
@@ -34,8 +50,46 @@ void leptonBeginSPI() {
 	digitalWrite(pin_lepton_cs, LOW);
 }
 
+/* Start the reception of the next packet in the background */
+void leptonStartPacket() {
+	//Transmit dummy bytes to the SPI FIFO
+	leptonDMATX.source(leptonDummy);
+	leptonDMATX.destination((volatile uint8_t&)KINETISK_SPI0.PUSHR);
+	leptonDMATX.transferCount(164);
+	leptonDMATX.disableOnCompletion();
+	leptonDMATX.triggerAtHardwareEvent(DMAMUX_SOURCE_SPI0_TX);
+	//Receive the answer into the free buffer
+	leptonDMARX.source((volatile uint8_t&)KINETISK_SPI0.POPR);
+	leptonDMARX.destinationBuffer(leptonBuffer[leptonBufferIndex], 164);
+	leptonDMARX.disableOnCompletion();
+	leptonDMARX.triggerAtHardwareEvent(DMAMUX_SOURCE_SPI0_RX);
+	//Clear the FIFOs and flags, then let the SPI request DMA
+	KINETISK_SPI0.MCR |= SPI_MCR_CLR_RXF | SPI_MCR_CLR_TXF;
+	KINETISK_SPI0.SR = 0xFF0F0000;
+	KINETISK_SPI0.RSER = SPI_RSER_RFDF_RE | SPI_RSER_RFDF_DIRS | SPI_RSER_TFFF_RE | SPI_RSER_TFFF_DIRS;
+	//Start reception
+	leptonPacketPending = true;
+	leptonDMARX.enable();
+	leptonDMATX.enable();
+}
+
+/* Wait until the packet in the background has been received */
+void leptonWaitPacket() {
+	if (!leptonPacketPending)
+		return;
+	while (!leptonDMARX.complete());
+	leptonDMARX.clearComplete();
+	leptonDMATX.clearComplete();
+	//Stop the DMA requests of the SPI
+	KINETISK_SPI0.RSER = 0;
+	KINETISK_SPI0.SR = 0xFF0F0000;
+	leptonPacketPending = false;
+}
+
 /* End Lepton SPI Transmission */
 void leptonEndSPI() {
+	//Drop the packet received in the background
+	leptonWaitPacket();
 	//End transfer - CS HIGH
 	digitalWriteFast(pin_lepton_cs, HIGH);
 	//End SPI Transaction
@@ -45,25 +99,22 @@ void leptonEndSPI() {
 		endAltClockline();
 }
 
-/* Reads one line (164 Bytes) from the lepton over SPI */
-bool leptonReadFrame(byte line, byte seg) {
-	//Receive one frame over SPI
-	SPI.transfer(leptonFrame, 164);
-	//Repeat as long as the frame is not valid, equals sync
-	if ((leptonFrame[0] & 0x0F) == 0x0F) {
-		return false;
-	}
-	//Check if the line number matches the expected line
-	if (leptonFrame[1] != line) {
-		return false;
-	}
-	//For the Lepton3, check if the segment number matches
-	if ((line == 20) && (leptonVersion == leptonVersion_3_Shutter)) {
-		byte segment = (leptonFrame[0] >> 4);
-		if (segment != seg)
-			return false;
-	}
-	return true;
+/* Reads one packet (164 Bytes) from the lepton over SPI */
+void leptonReadPacket() {
+	//Receive one packet, if not already done in the background
+	if (!leptonPacketPending)
+		leptonStartPacket();
+	leptonWaitPacket();
+	//Switch to the received buffer
+	leptonFrame = leptonBuffer[leptonBufferIndex];
+	leptonBufferIndex ^= 1;
+	//Receive the next packet while this one is processed
+	leptonStartPacket();
+}
+
+/* Check the CRC of the received packet */
+bool leptonCheckCRC() {
+	return leptonCRC(leptonFrame) == ((leptonFrame[2] << 8) | leptonFrame[3]);
 }
 
 /* Trigger a flat-field-correction on the Lepton */
@@ -141,6 +141,8 @@ void massStorage() {
 	//Show message
 	showFullMessage((char*) "Disconnect USB cable to return!");
 	delay(1500);
+	//The files can be changed from the computer, build the catalog again
+	catalogInvalidate();
 	//Set marker
 	EEPROM.write(eeprom_massStorage, eeprom_setValue);
 	restartAndJumpToApp();
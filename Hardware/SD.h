@@ -13,6 +13,13 @@
 *
 */
 
+/* Defines */
+
+//Size of the SD card benchmark file in blocks, 2MB
+#define benchmark_sdBlocks 4096
+//Name of the SD card benchmark file
+#define benchmark_sdFile "BENCH.TMP"
+
 /* Variables */
 
 //Card
@@ -301,4 +308,76 @@ void formatCard() {
 	writeCache(fatStart + fatSize);
 	//End SD
 	endAltClockline();
+}
+
+/* Print the speed of one SD card transfer */
+void benchmarkSpeed(const char* name, uint32_t time, bool success) {
+	Serial.print(name);
+	Serial.print(": ");
+	if ((!success) || (time == 0)) {
+		Serial.println("failed");
+		return;
+	}
+	//Bytes per microsecond are MB/s
+	Serial.print((float)((uint32_t)benchmark_sdBlocks * 512) / time, 2);
+	Serial.println(" MB/s");
+}
+
+/* Measure the sustained write and read speed of the inserted SD card */
+void benchmarkSDCard() {
+	SdFile benchFile;
+	byte buffer[512];
+	uint32_t firstBlock, lastBlock, measure;
+	bool success;
+
+	//Switch Clock to Alternative
+	startAltClockline(true);
+	//Test file in one contiguous block
+	sd.chdir("/");
+	sd.remove(benchmark_sdFile);
+	if ((!benchFile.createContiguous(sd.vwd(), benchmark_sdFile, (uint32_t)benchmark_sdBlocks * 512))
+		|| (!benchFile.contiguousRange(&firstBlock, &lastBlock))) {
+		Serial.println("SD card benchmark failed, not enough space !");
+		endAltClockline();
+		return;
+	}
+	//Test pattern
+	for (uint16_t i = 0; i < 512; i++)
+		buffer[i] = i;
+
+	Serial.println("*** SD Card Benchmark ***");
+	//Single block writes through the file system
+	measure = micros();
+	success = true;
+	for (uint16_t i = 0; i < benchmark_sdBlocks; i++)
+		success &= (benchFile.write(buffer, 512) == 512);
+	success &= benchFile.sync();
+	benchmarkSpeed("File write", micros() - measure, success);
+
+	//Multi-block write to the pre-erased blocks, like the video recording
+	sd.card()->erase(firstBlock, lastBlock);
+	measure = micros();
+	success = sd.card()->writeStart(firstBlock, benchmark_sdBlocks);
+	//Only stop a transfer that has been started
+	if (success) {
+		for (uint16_t i = 0; (success) && (i < benchmark_sdBlocks); i++)
+			success = sd.card()->writeData(buffer);
+		success &= sd.card()->writeStop();
+	}
+	benchmarkSpeed("Stream write", micros() - measure, success);
+
+	//Multi-block read
+	measure = micros();
+	success = sd.card()->readStart(firstBlock);
+	if (success) {
+		for (uint16_t i = 0; (success) && (i < benchmark_sdBlocks); i++)
+			success = sd.card()->readData(buffer);
+		success &= sd.card()->readStop();
+	}
+	benchmarkSpeed("Stream read", micros() - measure, success);
+
+	//Delete the test file
+	benchFile.remove();
+	//Switch clock back
+	endAltClockline();
 }
\ No newline at end of file
@@ -0,0 +1,373 @@
+/*
+*
+* SERIAL FRAME - Frames of the serial protocol version 2
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+/*
+* Frame layout, all values LSB first:
+* - Header: "TC", version, type (FRAME_*), format, flags, sequence number,
+*   width, height and the 32 bit payload length
+* - Palette if frameFlag_palette: number of colors and the RGB565 colors
+* - Pixels: raw values, RGB565 colors, color indices or the RawCodec output
+*   followed by its 32 bit size, which is not counted in the payload length
+* - Metadata: min and max raw value, spot temp, calibration offset and slope,
+*   the 192 temperature points
+* - CRC16-CCITT (start 0xFFFF) over header and payload
+* Button events are frames without payload. Delta frames (frameFlag_delta)
+* need the previous compressed frame, a keyframe follows every lost frame.
+* The reference lives behind the native Lepton2 frame, there is no RAM for
+* a second Lepton3 frame, so Lepton3 always sends keyframes.
+* The FrameDecoder library decodes the frames on the host.
+*/
+
+/* Defines */
+
+//Types of frame responses
+#define FRAME_CAPTURE     180
+#define FRAME_STARTVID    181
+#define FRAME_STOPVID     182
+#define FRAME_NORMAL      183
+
+//Frame formats of the protocol version 2
+#define frameFormat_raw        0
+#define frameFormat_color      1
+#define frameFormat_indexed    2
+#define frameFormat_compressed 3
+#define frameFormat_total      4
+//Frame layout of the protocol version 2
+#define frameV2_version     2
+#define frameV2_headerSize  16
+#define frameV2_metaSize    400
+//Compressed frames: the size of the coded values follows them, it is not part of the header length
+#define frameV2_sizeTrailer 4
+//The frame is collected in this buffer and sent with bulk writes
+#define frameV2_bufferSize  512
+//Flags of the protocol version 2
+#define frameFlag_palette   0x01
+#define frameFlag_delta     0x02
+//Maximum number of delta frames between two keyframes
+#define frameV2_keyInterval 30
+
+/* Variables */
+
+//Command, default send frame
+byte sendCmd = FRAME_NORMAL;
+
+//Sequence number of the v2 frames
+uint16_t frameSequence = 0;
+//CRC of the v2 frame in transmission
+uint16_t frameCRC;
+//Palette of the indexed frames has been sent and its CRC
+bool paletteSent = false;
+uint16_t paletteCRC;
+//Staging buffer of the v2 frame, sent with one bulk write when full
+byte frameBuffer[frameV2_bufferSize];
+uint16_t frameBufferPos = 0;
+//Reference for the delta frames, Lepton2 only, behind the native image
+uint16_t* deltaReference = &image[19200 - 4800];
+//Cleared when the end of the image buffer is used for something else
+bool deltaValid = false;
+//Delta frames since the last keyframe
+byte deltaCount = 0;
+//Region of interest of the raw frames, zero size for the full frame
+byte roiX = 0;
+byte roiY = 0;
+byte roiWidth = 0;
+byte roiHeight = 0;
+//Only every n-th value of every n-th line
+byte roiStep = 1;
+//Raw values to send, value (x,y) is frameRawStart[y * frameRawLineStep + x * frameRawPixelStep]
+const uint16_t* frameRawStart;
+byte frameRawPixelStep;
+uint16_t frameRawLineStep;
+//Layout covers the whole frame
+bool frameRawFull;
+
+/* Methods */
+
+/* Calculates the CRC16-CCITT, same table as the Lepton packets */
+uint16_t frameCRCCalc(const void* data, uint32_t length, uint16_t crc) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (uint32_t i = 0; i < length; i++)
+		crc = (crc << 8) ^ leptonCRCTable[(crc >> 8) ^ bytes[i]];
+	return crc;
+}
+
+/* Sends the staging buffer with one bulk write and adds it to the CRC */
+void frameFlush() {
+	frameCRC = frameCRCCalc(frameBuffer, frameBufferPos, frameCRC);
+	Serial.write(frameBuffer, frameBufferPos);
+	frameBufferPos = 0;
+}
+
+/* Adds a block to the v2 frame, large blocks are sent straight from their buffer */
+void frameWrite(const void* data, uint32_t length) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	//Fill up the staging buffer and send it
+	if ((frameBufferPos + length) >= frameV2_bufferSize) {
+		uint16_t part = frameV2_bufferSize - frameBufferPos;
+		memcpy(&frameBuffer[frameBufferPos], bytes, part);
+		frameBufferPos += part;
+		frameFlush();
+		bytes += part;
+		length -= part;
+	}
+	//The rest of a large block without copying it
+	if (length >= frameV2_bufferSize) {
+		frameCRC = frameCRCCalc(bytes, length, frameCRC);
+		Serial.write(bytes, length);
+		return;
+	}
+	memcpy(&frameBuffer[frameBufferPos], bytes, length);
+	frameBufferPos += length;
+}
+
+/* Sends the rest of the v2 frame together with the CRC */
+void frameEnd() {
+	//CRC over header and payload
+	frameCRC = frameCRCCalc(frameBuffer, frameBufferPos, frameCRC);
+	if ((frameBufferPos + 2) > frameV2_bufferSize) {
+		Serial.write(frameBuffer, frameBufferPos);
+		frameBufferPos = 0;
+	}
+	frameBuffer[frameBufferPos++] = frameCRC & 0x00FF;
+	frameBuffer[frameBufferPos++] = (frameCRC & 0xFF00) >> 8;
+	Serial.write(frameBuffer, frameBufferPos);
+	frameBufferPos = 0;
+}
+
+/* Stores a 16 bit value for the v2 frame, LSB first */
+void frameStoreWord(byte* buffer, uint16_t value) {
+	buffer[0] = value & 0x00FF;
+	buffer[1] = (value & 0xFF00) >> 8;
+}
+
+/* Sends the color palette of the indexed frames */
+void frameSendPalette() {
+	byte count[2];
+	frameStoreWord(count, colorLUTCount);
+	frameWrite(count, 2);
+	frameWrite(colorLUT, colorLUTCount * 2);
+}
+
+/* Collects the output of the codec in the staging buffer */
+void frameWriteByte(uint8_t value) {
+	frameBuffer[frameBufferPos++] = value;
+	if (frameBufferPos == frameV2_bufferSize)
+		frameFlush();
+}
+
+/* Selects the raw values to send from the region of interest and the decimation */
+void frameRawLayout(uint16_t* width, uint16_t* height) {
+	//Full frame inside the image buffer
+	uint16_t fullWidth = 160, fullHeight = 120;
+	frameRawPixelStep = 1;
+	frameRawLineStep = 160;
+	//Lepton2 in the native size
+	if (imageNative) {
+		fullWidth = 80;
+		fullHeight = 60;
+		frameRawLineStep = 80;
+	}
+	//Lepton2 upscaled, every second pixel of every second line
+	else if (leptonVersion != leptonVersion_3_Shutter) {
+		fullWidth = 80;
+		fullHeight = 60;
+		frameRawPixelStep = 2;
+		frameRawLineStep = 320;
+	}
+
+	//Region inside the frame, the full frame if not set
+	uint16_t x = roiX, y = roiY, w = roiWidth, h = roiHeight;
+	if ((w == 0) || (h == 0) || (x >= fullWidth) || (y >= fullHeight)) {
+		x = 0;
+		y = 0;
+		w = fullWidth;
+		h = fullHeight;
+	}
+	if ((x + w) > fullWidth)
+		w = fullWidth - x;
+	if ((y + h) > fullHeight)
+		h = fullHeight - y;
+	frameRawStart = &image[(y * frameRawLineStep) + (x * frameRawPixelStep)];
+	frameRawFull = (w == fullWidth) && (h == fullHeight) && (roiStep == 1);
+
+	//Take every n-th value of every n-th line
+	*width = (w + roiStep - 1) / roiStep;
+	*height = (h + roiStep - 1) / roiStep;
+	frameRawPixelStep *= roiStep;
+	frameRawLineStep *= roiStep;
+}
+
+/* Sends the raw values of the layout */
+void frameSendRaw(uint16_t width, uint16_t height) {
+	//All values in one block
+	if ((frameRawPixelStep == 1) && (frameRawLineStep == width)) {
+		frameWrite(frameRawStart, (uint32_t)width * height * 2);
+		return;
+	}
+	//Line by line
+	uint16_t line[160];
+	for (uint16_t y = 0; y < height; y++) {
+		const uint16_t* src = &frameRawStart[y * frameRawLineStep];
+		if (frameRawPixelStep == 1)
+			frameWrite(src, width * 2);
+		else {
+			for (uint16_t x = 0; x < width; x++)
+				line[x] = src[x * frameRawPixelStep];
+			frameWrite(line, width * 2);
+		}
+	}
+}
+
+/* Checks if the raw values are sent as delta frame, by the estimate of the codec */
+bool frameUseDelta(uint16_t width, uint16_t height) {
+	//Delta frames only for the full Lepton2 frame, the reference fits behind it
+	if ((!imageNative) || (!frameRawFull))
+		return false;
+	//Keyframe after some time or if the reference has been overwritten
+	if ((!deltaValid) || (deltaCount >= frameV2_keyInterval))
+		return false;
+	return rawCodec.costDelta(image, deltaReference, width, height)
+		< rawCodec.cost(frameRawStart, width, height, frameRawPixelStep, frameRawLineStep);
+}
+
+/* Sends the compressed raw values followed by their size, keeps them as reference for the next frame */
+void frameSendCompressed(byte flags, uint16_t width, uint16_t height) {
+	uint32_t size;
+	byte trailer[frameV2_sizeTrailer];
+	//Encoded once, straight into the staging buffer
+	if (flags & frameFlag_delta)
+		size = rawCodec.encodeDelta(image, deltaReference, 4800, frameWriteByte);
+	else
+		size = rawCodec.encode(frameRawStart, width, height, frameRawPixelStep, frameRawLineStep, frameWriteByte);
+	frameStoreWord(&trailer[0], size & 0xFFFF);
+	frameStoreWord(&trailer[2], size >> 16);
+	frameWrite(trailer, frameV2_sizeTrailer);
+
+	//Store the reference for the next delta frame
+	deltaValid = (imageNative) && (frameRawFull);
+	if (deltaValid) {
+		memcpy(deltaReference, image, 9600);
+		if (flags & frameFlag_delta)
+			deltaCount++;
+		else
+			deltaCount = 0;
+	}
+}
+
+/* Sends the limits, spot temp, calibration and the temperature points */
+void frameSendMeta() {
+	byte meta[16];
+	frameStoreWord(&meta[0], minTemp);
+	frameStoreWord(&meta[2], maxTemp);
+	floatToBytes(&meta[4], frameStats.spot);
+	floatToBytes(&meta[8], (float)calOffset);
+	floatToBytes(&meta[12], (float)calSlope);
+	frameWrite(meta, 16);
+	frameWrite(showTemp, 384);
+}
+
+/* Sends a frame of the protocol version 2 with header and CRC */
+void sendFrameV2(byte format) {
+	byte header[frameV2_headerSize];
+	uint16_t width = 0, height = 0;
+	uint32_t length = 0, size = 0;
+	byte flags = 0;
+
+	//Buttons events are sent as frames without content
+	byte type = sendCmd;
+	if (type != FRAME_NORMAL)
+		sendCmd = FRAME_NORMAL;
+	//Prepare the frame
+	else {
+		width = 160;
+		height = 120;
+		//Convert to colors or color indices
+		if ((format == frameFormat_color) || (format == frameFormat_indexed)) {
+			//Apply low-pass filter
+			if (filterType == filterType_box)
+				boxFilter();
+			else if (filterType == filterType_gaussian)
+				gaussianFilter();
+		}
+		//Convert to RGB565
+		if (format == frameFormat_color) {
+			convertColors();
+			size = (uint32_t)width * height * 2;
+		}
+		//One byte per pixel, Lepton2 stays in the native size
+		else if (format == frameFormat_indexed) {
+			convertIndices();
+			if (imageNative) {
+				width = 80;
+				height = 60;
+			}
+			size = (uint32_t)width * height;
+			//Add the palette only when it has changed
+			uint16_t crc = frameCRCCalc(colorLUT, colorLUTCount * 2, 0xFFFF);
+			if ((!paletteSent) || (crc != paletteCRC)) {
+				flags |= frameFlag_palette;
+				length += 2 + (colorLUTCount * 2);
+				paletteSent = true;
+				paletteCRC = crc;
+			}
+		}
+		//Raw values of the region of interest, Lepton2 sends 80x60 values
+		else {
+			frameRawLayout(&width, &height);
+			//Compressed raw values, delta to the previous frame if possible
+			if (format == frameFormat_compressed) {
+				if (frameUseDelta(width, height))
+					flags |= frameFlag_delta;
+				//The coded size is not known before, it is sent behind the values
+				size = frameV2_sizeTrailer;
+			}
+			else
+				size = (uint32_t)width * height * 2;
+		}
+		length += size + frameV2_metaSize;
+	}
+
+	//Sync bytes, version, type, format and flags
+	header[0] = 'T';
+	header[1] = 'C';
+	header[2] = frameV2_version;
+	header[3] = type;
+	header[4] = format;
+	header[5] = flags;
+	//Sequence number, size and payload length
+	frameStoreWord(&header[6], frameSequence++);
+	frameStoreWord(&header[8], width);
+	frameStoreWord(&header[10], height);
+	frameStoreWord(&header[12], length & 0xFFFF);
+	frameStoreWord(&header[14], length >> 16);
+
+	//Header and payload
+	frameCRC = 0xFFFF;
+	frameBufferPos = 0;
+	frameWrite(header, frameV2_headerSize);
+	if (length != 0) {
+		if (flags & frameFlag_palette)
+			frameSendPalette();
+		if (format == frameFormat_compressed)
+			frameSendCompressed(flags, width, height);
+		else if (format == frameFormat_raw)
+			frameSendRaw(width, height);
+		//Colors or color indices
+		else
+			frameWrite(image, size);
+		frameSendMeta();
+	}
+	frameEnd();
+}
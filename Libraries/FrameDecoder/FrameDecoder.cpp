@@ -0,0 +1,211 @@
+/*
+*
+* FRAME DECODER - Decodes the frames of the serial protocol version 2 on the host
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#include <string.h>
+#include "FrameDecoder.h"
+
+//Fixed parts of the frame
+#define headerSize  16
+#define metaSize    400
+#define trailerSize 4
+#define crcSize     2
+
+//Data of the codec, it reads through a function without context
+static const uint8_t* codecData;
+static uint32_t codecPos;
+static uint32_t codecLength;
+
+/* Read function of the codec, counts the bytes behind the end */
+static uint8_t codecRead() {
+	uint8_t value = (codecPos < codecLength) ? codecData[codecPos] : 0;
+	codecPos++;
+	return value;
+}
+
+/* Starts without a reference */
+FrameDecoder::FrameDecoder() {
+	reset();
+	paletteCount = 0;
+}
+
+/* Forgets the reference and the sequence */
+void FrameDecoder::reset() {
+	referenceValid = false;
+	referenceCount = 0;
+	lastValid = false;
+}
+
+/* 16 bit value, LSB first */
+uint16_t FrameDecoder::getWord(const uint8_t* data) {
+	return data[0] | (data[1] << 8);
+}
+
+/* 32 bit value, LSB first */
+uint32_t FrameDecoder::getLong(const uint8_t* data) {
+	return getWord(data) | ((uint32_t)getWord(&data[2]) << 16);
+}
+
+/* Float from four bytes, LSB first */
+float FrameDecoder::getFloat(const uint8_t* data) {
+	uint32_t value = getLong(data);
+	float result;
+	memcpy(&result, &value, 4);
+	return result;
+}
+
+/* CRC16-CCITT with the start value 0xFFFF */
+uint16_t FrameDecoder::calcCRC(const uint8_t* data, uint32_t length) {
+	uint16_t crc = 0xFFFF;
+	for (uint32_t i = 0; i < length; i++) {
+		crc ^= data[i] << 8;
+		for (uint8_t bit = 0; bit < 8; bit++)
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+	}
+	return crc;
+}
+
+/* Parses and decodes the frame at the start of the data */
+int8_t FrameDecoder::parse(const uint8_t* data, uint32_t length, uint32_t* used) {
+	//Search the sync bytes, drop everything before them
+	*used = 0;
+	while ((*used < length) && (data[*used] != 'T'))
+		(*used)++;
+	if (*used != 0)
+		return FRAMEDECODER_ERROR;
+	if (length < headerSize)
+		return FRAMEDECODER_MORE;
+	//No frame start, go on with the next byte
+	*used = 1;
+	if ((data[1] != 'C') || (data[2] != 2))
+		return FRAMEDECODER_ERROR;
+
+	uint8_t frameFormat = data[4];
+	uint8_t frameFlags = data[5];
+	uint16_t frameWidth = getWord(&data[8]);
+	uint16_t frameHeight = getWord(&data[10]);
+	uint32_t payload = getLong(&data[12]);
+	uint32_t count = (uint32_t)frameWidth * frameHeight;
+	bool compressed = (payload != 0) && (frameFormat == FRAMEDECODER_COMPRESSED);
+	bool delta = compressed && (frameFlags & FRAMEDECODER_DELTA);
+	if ((count > 19200) || (frameFormat > FRAMEDECODER_COMPRESSED))
+		return FRAMEDECODER_ERROR;
+
+	//Palette in front of the pixels
+	uint32_t pos = headerSize;
+	uint16_t colors = 0;
+	if ((payload != 0) && (frameFlags & FRAMEDECODER_PALETTE)) {
+		if (length < (pos + 2))
+			return FRAMEDECODER_MORE;
+		colors = getWord(&data[pos]);
+		if (colors > 256)
+			return FRAMEDECODER_ERROR;
+		pos += 2 + (colors * 2);
+	}
+
+	//The payload length has to match the size
+	uint32_t pixelSize = count * 2;
+	if (frameFormat == FRAMEDECODER_INDEXED)
+		pixelSize = count;
+	else if (frameFormat == FRAMEDECODER_COMPRESSED)
+		pixelSize = trailerSize;
+	if ((payload != 0) && (payload != ((pos - headerSize) + pixelSize + metaSize)))
+		return FRAMEDECODER_ERROR;
+
+	//The size of the coded values is only known after decoding them
+	uint32_t coded = 0;
+	bool missing = delta && ((!referenceValid) || (referenceCount != count));
+	if (compressed) {
+		codecData = &data[pos];
+		codecPos = 0;
+		codecLength = (length > pos) ? length - pos : 0;
+		//Without the reference, decode against zero to find the end
+		if (missing)
+			memset(reference, 0, sizeof(reference));
+		if (delta)
+			codec.decodeDelta(decoded, reference, count, codecRead);
+		else
+			codec.decode(decoded, frameWidth, frameHeight, codecRead);
+		if (codecPos > codecLength)
+			return FRAMEDECODER_MORE;
+		coded = codecPos;
+		if ((length >= (pos + coded + trailerSize)) && (getLong(&data[pos + coded]) != coded))
+			return FRAMEDECODER_ERROR;
+	}
+
+	//Complete frame with the CRC
+	uint32_t total = headerSize + coded + payload + crcSize;
+	if (length < total)
+		return FRAMEDECODER_MORE;
+	if (calcCRC(data, total - crcSize) != getWord(&data[total - crcSize]))
+		return FRAMEDECODER_ERROR;
+	*used = total;
+
+	//A frame has been lost, the reference does not match anymore
+	uint16_t frameSequence = getWord(&data[6]);
+	if ((lastValid) && (frameSequence != (uint16_t)(lastSequence + 1))) {
+		referenceValid = false;
+		missing = delta;
+	}
+	lastSequence = frameSequence;
+	lastValid = true;
+	//Delta frame without its reference, wait for the next keyframe
+	if (missing) {
+		referenceValid = false;
+		return FRAMEDECODER_ERROR;
+	}
+
+	type = data[3];
+	format = frameFormat;
+	flags = frameFlags;
+	sequence = frameSequence;
+	width = frameWidth;
+	height = frameHeight;
+	//Button events have no content
+	if (payload == 0)
+		return FRAMEDECODER_FRAME;
+
+	//Palette
+	if (flags & FRAMEDECODER_PALETTE) {
+		paletteCount = colors;
+		for (uint16_t i = 0; i < colors; i++)
+			palette[i] = getWord(&data[headerSize + 2 + (i * 2)]);
+	}
+	//Pixels, compressed values are the reference for the next delta frame
+	if (format == FRAMEDECODER_COMPRESSED) {
+		memcpy(pixels, decoded, count * 2);
+		memcpy(reference, decoded, count * 2);
+		referenceCount = count;
+		referenceValid = true;
+		pos += coded + trailerSize;
+	}
+	else if (format == FRAMEDECODER_INDEXED) {
+		memcpy(indices, &data[pos], count);
+		pos += count;
+	}
+	else {
+		for (uint32_t i = 0; i < count; i++)
+			pixels[i] = getWord(&data[pos + (i * 2)]);
+		pos += count * 2;
+	}
+	//Metadata
+	minTemp = getWord(&data[pos]);
+	maxTemp = getWord(&data[pos + 2]);
+	spotTemp = getFloat(&data[pos + 4]);
+	calOffset = getFloat(&data[pos + 8]);
+	calSlope = getFloat(&data[pos + 12]);
+	for (uint8_t i = 0; i < 192; i++)
+		points[i] = getWord(&data[pos + 16 + (i * 2)]);
+	return FRAMEDECODER_FRAME;
+}
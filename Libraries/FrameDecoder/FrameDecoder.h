@@ -0,0 +1,93 @@
+/*
+*
+* FRAME DECODER - Decodes the frames of the serial protocol version 2 on the host
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#ifndef FrameDecoder_h
+#define FrameDecoder_h
+
+#include <stdint.h>
+#include "RawCodec.h"
+
+//Results of parse
+#define FRAMEDECODER_FRAME  1
+#define FRAMEDECODER_MORE   0
+#define FRAMEDECODER_ERROR -1
+
+//Frame formats, same as in the firmware
+#define FRAMEDECODER_RAW        0
+#define FRAMEDECODER_COLOR      1
+#define FRAMEDECODER_INDEXED    2
+#define FRAMEDECODER_COMPRESSED 3
+//Flags
+#define FRAMEDECODER_PALETTE    0x01
+#define FRAMEDECODER_DELTA      0x02
+
+/*
+* Takes the bytes received from the camera and decodes the frames, see
+* Hardware/SerialFrame.h for the layout. Delta frames are decoded with the
+* previous compressed frame. Only Lepton2 sends them, Lepton3 sends keyframes.
+* After a lost or broken frame, delta frames are rejected until the next keyframe. The code has no dependencies besides
+* RawCodec, so the desktop tools can use it unchanged.
+*/
+class FrameDecoder
+{
+public:
+	FrameDecoder();
+	//Forgets the reference, for a new connection
+	void reset();
+	//Parses the frame at the start of the data. Returns FRAMEDECODER_FRAME with the
+	//fields below filled, FRAMEDECODER_MORE if the frame is not complete yet or
+	//FRAMEDECODER_ERROR. Used is the number of bytes to drop from the data
+	int8_t parse(const uint8_t* data, uint32_t length, uint32_t* used);
+
+	//Header of the last frame
+	uint8_t type;
+	uint8_t format;
+	uint8_t flags;
+	uint16_t sequence;
+	uint16_t width;
+	uint16_t height;
+	//Raw values or RGB565 colors, width x height
+	uint16_t pixels[19200];
+	//Color indices and the last palette
+	uint8_t indices[19200];
+	uint16_t palette[256];
+	uint16_t paletteCount;
+	//Metadata
+	uint16_t minTemp;
+	uint16_t maxTemp;
+	float spotTemp;
+	float calOffset;
+	float calSlope;
+	uint16_t points[192];
+
+private:
+	uint16_t getWord(const uint8_t* data);
+	uint32_t getLong(const uint8_t* data);
+	float getFloat(const uint8_t* data);
+	uint16_t calcCRC(const uint8_t* data, uint32_t length);
+
+	RawCodec codec;
+	//Compressed values until the CRC has been checked
+	uint16_t decoded[19200];
+	//Previous compressed frame for the delta frames
+	uint16_t reference[19200];
+	uint16_t referenceCount;
+	bool referenceValid;
+	//Sequence number of the last decoded frame
+	uint16_t lastSequence;
+	bool lastValid;
+};
+
+#endif
@@ -0,0 +1,209 @@
+/*
+*
+* QOI CODEC - Lossless "Quite OK Image" format for the RGB565 frames
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#include "QOICodec.h"
+
+//Chunk tags
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xC0
+#define QOI_OP_RGB   0xFE
+#define QOI_MASK_2   0xC0
+
+//Pixels are stored as 0x00RRGGBB, alpha is always 255
+#define QOI_R(px) (((px) >> 16) & 0xFF)
+#define QOI_G(px) (((px) >> 8) & 0xFF)
+#define QOI_B(px) ((px) & 0xFF)
+#define QOI_HASH(px) (((QOI_R(px) * 3) + (QOI_G(px) * 5) + (QOI_B(px) * 7) + (255 * 11)) & 63)
+
+/* Expand RGB565 to RGB888, the low bits repeat the high bits */
+static inline uint32_t expand(uint16_t color) {
+	uint32_t r = (color >> 11) & 0x1F;
+	uint32_t g = (color >> 5) & 0x3F;
+	uint32_t b = color & 0x1F;
+	return (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+}
+
+/* Reduce RGB888 to RGB565 */
+static inline uint16_t reduce(uint32_t px) {
+	return ((QOI_R(px) >> 3) << 11) | ((QOI_G(px) >> 2) << 5) | (QOI_B(px) >> 3);
+}
+
+/* Clears the color index and the previous pixel */
+void QOICodec::reset() {
+	for (uint8_t i = 0; i < 64; i++)
+		index[i] = 0xFFFFFFFF;
+	previous = 0;
+	run = 0;
+}
+
+/* Writes a 32 bit value, MSB first */
+void QOICodec::putLong(uint32_t value) {
+	writeByte(value >> 24);
+	writeByte(value >> 16);
+	writeByte(value >> 8);
+	writeByte(value);
+}
+
+/* Reads a 32 bit value, MSB first */
+uint32_t QOICodec::getLong() {
+	uint32_t value = 0;
+	for (uint8_t i = 0; i < 4; i++)
+		value = (value << 8) | readByte();
+	return value;
+}
+
+/* Writes the header and starts the encoder */
+void QOICodec::beginEncode(uint32_t width, uint32_t height, void (*write)(uint8_t)) {
+	writeByte = write;
+	writeByte('q');
+	writeByte('o');
+	writeByte('i');
+	writeByte('f');
+	putLong(width);
+	putLong(height);
+	//RGB, sRGB with linear alpha
+	writeByte(3);
+	writeByte(0);
+	reset();
+}
+
+/* Encodes the next pixels */
+void QOICodec::encode(const uint16_t* pixels, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t px = expand(pixels[i]);
+
+		//Same as before, extend the run
+		if (px == previous) {
+			run++;
+			if (run == 62) {
+				writeByte(QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+			continue;
+		}
+		if (run > 0) {
+			writeByte(QOI_OP_RUN | (run - 1));
+			run = 0;
+		}
+
+		//Seen recently
+		uint8_t hash = QOI_HASH(px);
+		if (index[hash] == px)
+			writeByte(QOI_OP_INDEX | hash);
+		else {
+			index[hash] = px;
+			int8_t dr = QOI_R(px) - QOI_R(previous);
+			int8_t dg = QOI_G(px) - QOI_G(previous);
+			int8_t db = QOI_B(px) - QOI_B(previous);
+			int8_t dr_dg = dr - dg;
+			int8_t db_dg = db - dg;
+			//Small difference
+			if ((dr > -3) && (dr < 2) && (dg > -3) && (dg < 2) && (db > -3) && (db < 2))
+				writeByte(QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+			//Difference relative to green
+			else if ((dg > -33) && (dg < 32) && (dr_dg > -9) && (dr_dg < 8) && (db_dg > -9) && (db_dg < 8)) {
+				writeByte(QOI_OP_LUMA | (dg + 32));
+				writeByte(((dr_dg + 8) << 4) | (db_dg + 8));
+			}
+			//Full color
+			else {
+				writeByte(QOI_OP_RGB);
+				writeByte(QOI_R(px));
+				writeByte(QOI_G(px));
+				writeByte(QOI_B(px));
+			}
+		}
+		previous = px;
+	}
+}
+
+/* Writes the last run and the end marker */
+void QOICodec::endEncode() {
+	if (run > 0) {
+		writeByte(QOI_OP_RUN | (run - 1));
+		run = 0;
+	}
+	for (uint8_t i = 0; i < 7; i++)
+		writeByte(0);
+	writeByte(1);
+}
+
+/* Reads the header and starts the decoder */
+bool QOICodec::beginDecode(uint32_t* width, uint32_t* height, uint8_t (*read)(void)) {
+	readByte = read;
+	if ((readByte() != 'q') || (readByte() != 'o') || (readByte() != 'i') || (readByte() != 'f'))
+		return false;
+	*width = getLong();
+	*height = getLong();
+	//Channels and colorspace
+	readByte();
+	readByte();
+	reset();
+	return true;
+}
+
+/* Decodes the next pixels */
+void QOICodec::decode(uint16_t* pixels, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		//Continue the run
+		if (run > 0) {
+			run--;
+			pixels[i] = reduce(previous);
+			continue;
+		}
+
+		uint8_t b1 = readByte();
+		uint32_t px = previous;
+		if (b1 == QOI_OP_RGB) {
+			uint32_t r = readByte();
+			uint32_t g = readByte();
+			uint32_t b = readByte();
+			px = (r << 16) | (g << 8) | b;
+		}
+		//Alpha is not used, skip it
+		else if (b1 == 0xFF) {
+			uint32_t r = readByte();
+			uint32_t g = readByte();
+			uint32_t b = readByte();
+			readByte();
+			px = (r << 16) | (g << 8) | b;
+		}
+		else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+			px = index[b1];
+		else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+			uint8_t r = QOI_R(previous) + ((b1 >> 4) & 0x03) - 2;
+			uint8_t g = QOI_G(previous) + ((b1 >> 2) & 0x03) - 2;
+			uint8_t b = QOI_B(previous) + (b1 & 0x03) - 2;
+			px = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+		}
+		else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+			uint8_t b2 = readByte();
+			int8_t dg = (b1 & 0x3F) - 32;
+			uint8_t r = QOI_R(previous) + dg - 8 + ((b2 >> 4) & 0x0F);
+			uint8_t g = QOI_G(previous) + dg;
+			uint8_t b = QOI_B(previous) + dg - 8 + (b2 & 0x0F);
+			px = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+		}
+		//Run of the previous pixel, this one included
+		else
+			run = (b1 & 0x3F);
+
+		index[QOI_HASH(px)] = px;
+		previous = px;
+		pixels[i] = reduce(px);
+	}
+}
@@ -0,0 +1,56 @@
+/*
+*
+* QOI CODEC - Lossless "Quite OK Image" format for the RGB565 frames
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#ifndef QOICodec_h
+#define QOICodec_h
+
+#include <stdint.h>
+
+//Size of the header in front of the pixels
+#define QOI_HEADER_SIZE 14
+
+/*
+* Streaming encoder and decoder, the pixels can be passed in strips.
+* RGB565 is expanded to RGB888 for the file and rounded back when decoding.
+* The code has no dependencies, so the desktop tools can use it unchanged.
+*/
+class QOICodec
+{
+public:
+	//Writes the header and starts the encoder
+	void beginEncode(uint32_t width, uint32_t height, void (*write)(uint8_t));
+	//Encodes the next pixels
+	void encode(const uint16_t* pixels, uint32_t count);
+	//Writes the last run and the end marker
+	void endEncode();
+
+	//Reads the header and starts the decoder, returns false if no QOI file
+	bool beginDecode(uint32_t* width, uint32_t* height, uint8_t (*read)(void));
+	//Decodes the next pixels
+	void decode(uint16_t* pixels, uint32_t count);
+
+private:
+	void reset();
+	void putLong(uint32_t value);
+	uint32_t getLong();
+
+	uint32_t index[64];
+	uint32_t previous;
+	uint8_t run;
+	void (*writeByte)(uint8_t);
+	uint8_t (*readByte)(void);
+};
+
+#endif
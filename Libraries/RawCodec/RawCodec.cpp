@@ -0,0 +1,234 @@
+/*
+*
+* RAW CODEC - Lossless compression for the radiometric frames
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#include "RawCodec.h"
+
+/* Median edge detector from the left, upper and upper left pixel */
+static inline uint16_t predict(uint16_t left, uint16_t up, uint16_t upLeft) {
+	uint16_t min = (left < up) ? left : up;
+	uint16_t max = (left < up) ? up : left;
+	if (upLeft >= max)
+		return min;
+	if (upLeft <= min)
+		return max;
+	return left + up - upLeft;
+}
+
+/* Starts the adaptive model of the Rice parameter */
+void RawCodec::resetModel() {
+	modelSum = 4;
+	modelCount = 1;
+}
+
+/* Smallest parameter that covers the average of the recent values */
+uint8_t RawCodec::riceParameter() {
+	uint8_t k = 0;
+	while (((uint32_t)modelCount << k) < modelSum)
+		k++;
+	return k;
+}
+
+/* Adds a value to the model, old values fade out */
+void RawCodec::updateModel(uint16_t value) {
+	modelSum += value;
+	modelCount++;
+	if (modelCount == 64) {
+		modelSum >>= 1;
+		modelCount >>= 1;
+	}
+}
+
+/* Appends up to 24 bits, MSB first */
+void RawCodec::putBits(uint32_t value, uint8_t count) {
+	bitBuffer = (bitBuffer << count) | value;
+	bitCount += count;
+	while (bitCount >= 8) {
+		bitCount -= 8;
+		if (writeByte != 0)
+			writeByte(bitBuffer >> bitCount);
+		byteCount++;
+	}
+}
+
+/* Writes the last incomplete byte */
+void RawCodec::flushBits() {
+	if (bitCount != 0)
+		putBits(0, 8 - bitCount);
+}
+
+/* Reads up to 24 bits, MSB first */
+uint32_t RawCodec::getBits(uint8_t count) {
+	while (bitCount < count) {
+		bitBuffer = (bitBuffer << 8) | readByte();
+		bitCount += 8;
+	}
+	bitCount -= count;
+	return (bitBuffer >> bitCount) & ((1UL << count) - 1);
+}
+
+/* Stores the difference between pixel and prediction */
+void RawCodec::putResidual(uint16_t pixel, uint16_t pred) {
+	//Map the residual to a positive value
+	int16_t residual = (int16_t)(pixel - pred);
+	uint16_t value = (uint16_t)((residual << 1) ^ (residual >> 15));
+
+	//Rice code, escape large values
+	uint8_t k = riceParameter();
+	uint16_t q = value >> k;
+	if (q < RAWCODEC_LIMIT) {
+		while (q >= 16) {
+			putBits(0xFFFF, 16);
+			q -= 16;
+		}
+		putBits(((1UL << q) - 1) << 1, q + 1);
+		putBits(value & ((1UL << k) - 1), k);
+	}
+	else {
+		putBits(0xFFFF, 16);
+		putBits(0xFF, RAWCODEC_LIMIT - 16);
+		putBits(value, 16);
+	}
+	updateModel(value);
+}
+
+/* Reads a residual and adds it to the prediction */
+uint16_t RawCodec::getResidual(uint16_t pred) {
+	//Unary part, then the remainder or the escaped value
+	uint8_t k = riceParameter();
+	uint16_t q = 0;
+	while ((q < RAWCODEC_LIMIT) && getBits(1))
+		q++;
+	uint16_t value;
+	if (q == RAWCODEC_LIMIT)
+		value = getBits(16);
+	else
+		value = (q << k) | getBits(k);
+	updateModel(value);
+
+	//Back to the residual
+	int16_t residual = (int16_t)((value >> 1) ^ -(int16_t)(value & 1));
+	return pred + residual;
+}
+
+/* Encodes a frame, returns the number of bytes */
+uint32_t RawCodec::encode(const uint16_t* image, uint16_t width, uint16_t height,
+	uint8_t pixelStep, uint16_t lineStep, void (*write)(uint8_t)) {
+	writeByte = write;
+	bitBuffer = 0;
+	bitCount = 0;
+	byteCount = 0;
+	resetModel();
+
+	for (uint16_t y = 0; y < height; y++) {
+		const uint16_t* line = &image[y * lineStep];
+		const uint16_t* above = (y > 0) ? line - lineStep : line;
+		for (uint16_t x = 0; x < width; x++) {
+			uint16_t pred;
+			//First pixel
+			if ((x == 0) && (y == 0))
+				pred = 0;
+			//First line, take the left pixel
+			else if (y == 0)
+				pred = line[(x - 1) * pixelStep];
+			//First column, take the upper pixel
+			else if (x == 0)
+				pred = above[0];
+			else
+				pred = predict(line[(x - 1) * pixelStep], above[x * pixelStep], above[(x - 1) * pixelStep]);
+			putResidual(line[x * pixelStep], pred);
+		}
+	}
+	flushBits();
+	return byteCount;
+}
+
+/* Decodes a frame into a compact buffer */
+void RawCodec::decode(uint16_t* image, uint16_t width, uint16_t height, uint8_t (*read)(void)) {
+	readByte = read;
+	bitBuffer = 0;
+	bitCount = 0;
+	resetModel();
+
+	for (uint16_t y = 0; y < height; y++) {
+		uint16_t* line = &image[y * width];
+		uint16_t* above = (y > 0) ? line - width : line;
+		for (uint16_t x = 0; x < width; x++) {
+			uint16_t pred;
+			if ((x == 0) && (y == 0))
+				pred = 0;
+			else if (y == 0)
+				pred = line[x - 1];
+			else if (x == 0)
+				pred = above[0];
+			else
+				pred = predict(line[x - 1], above[x], above[x - 1]);
+			line[x] = getResidual(pred);
+		}
+	}
+}
+
+/* Encodes a delta frame, returns the number of bytes */
+uint32_t RawCodec::encodeDelta(const uint16_t* image, const uint16_t* reference, uint16_t count,
+	void (*write)(uint8_t)) {
+	writeByte = write;
+	bitBuffer = 0;
+	bitCount = 0;
+	byteCount = 0;
+	resetModel();
+
+	for (uint16_t i = 0; i < count; i++)
+		putResidual(image[i], reference[i]);
+	flushBits();
+	return byteCount;
+}
+
+/* Decodes a delta frame */
+void RawCodec::decodeDelta(uint16_t* image, const uint16_t* reference, uint16_t count, uint8_t (*read)(void)) {
+	readByte = read;
+	bitBuffer = 0;
+	bitCount = 0;
+	resetModel();
+
+	for (uint16_t i = 0; i < count; i++)
+		image[i] = getResidual(reference[i]);
+}
+
+/* Estimates the size of a frame from the residuals of every n-th line */
+uint32_t RawCodec::cost(const uint16_t* image, uint16_t width, uint16_t height,
+	uint8_t pixelStep, uint16_t lineStep) {
+	uint32_t sum = 0;
+	for (uint16_t y = 1; y < height; y += RAWCODEC_COSTSTEP) {
+		const uint16_t* line = &image[y * lineStep];
+		const uint16_t* above = line - lineStep;
+		for (uint16_t x = 1; x < width; x++) {
+			int16_t residual = (int16_t)(line[x * pixelStep]
+				- predict(line[(x - 1) * pixelStep], above[x * pixelStep], above[(x - 1) * pixelStep]));
+			sum += (residual < 0) ? -residual : residual;
+		}
+	}
+	return sum;
+}
+
+/* Estimates the size of a delta frame from the same pixels */
+uint32_t RawCodec::costDelta(const uint16_t* image, const uint16_t* reference, uint16_t width, uint16_t height) {
+	uint32_t sum = 0;
+	for (uint16_t y = 1; y < height; y += RAWCODEC_COSTSTEP) {
+		for (uint16_t x = 1; x < width; x++) {
+			int16_t residual = (int16_t)(image[(y * width) + x] - reference[(y * width) + x]);
+			sum += (residual < 0) ? -residual : residual;
+		}
+	}
+	return sum;
+}
@@ -0,0 +1,75 @@
+/*
+*
+* RAW CODEC - Lossless compression for the radiometric frames
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#ifndef RawCodec_h
+#define RawCodec_h
+
+#include <stdint.h>
+
+//First byte of a compressed frame, raw frames start with a 14 bit value
+#define RAWCODEC_MARKER  0xC1
+//Flags in the second byte
+#define RAWCODEC_LEPTON3 0x01
+#define RAWCODEC_POINTS  0x02
+//Maximum unary length, longer values are stored with 16 bits
+#define RAWCODEC_LIMIT   24
+//Only every n-th line is used for the size estimate
+#define RAWCODEC_COSTSTEP 4
+
+/*
+* Every pixel is predicted from its left, upper and upper left neighbour
+* (median edge detector). The residual is stored with an adaptive Rice code.
+* Delta frames predict every pixel from the same pixel of a reference frame.
+* The code has no dependencies, so the desktop tools can use it unchanged.
+*/
+class RawCodec
+{
+public:
+	//Encodes width x height pixels, pixel (x,y) is image[y * lineStep + x * pixelStep]
+	//Without a write function, only the size in bytes is calculated
+	uint32_t encode(const uint16_t* image, uint16_t width, uint16_t height,
+		uint8_t pixelStep, uint16_t lineStep, void (*write)(uint8_t));
+	//Decodes width x height pixels into a compact buffer
+	void decode(uint16_t* image, uint16_t width, uint16_t height, uint8_t (*read)(void));
+	//Encodes count pixels as difference to the reference, same size calculation
+	uint32_t encodeDelta(const uint16_t* image, const uint16_t* reference, uint16_t count,
+		void (*write)(uint8_t));
+	//Decodes count pixels of a delta frame, image and reference may be the same buffer
+	void decodeDelta(uint16_t* image, const uint16_t* reference, uint16_t count, uint8_t (*read)(void));
+	//Sum of the absolute residuals of some lines, to choose between encode and encodeDelta
+	//without encoding twice. The delta frame is a compact width x height buffer
+	uint32_t cost(const uint16_t* image, uint16_t width, uint16_t height, uint8_t pixelStep, uint16_t lineStep);
+	uint32_t costDelta(const uint16_t* image, const uint16_t* reference, uint16_t width, uint16_t height);
+
+private:
+	void resetModel();
+	uint8_t riceParameter();
+	void updateModel(uint16_t value);
+	void putResidual(uint16_t pixel, uint16_t pred);
+	uint16_t getResidual(uint16_t pred);
+	void putBits(uint32_t value, uint8_t count);
+	void flushBits();
+	uint32_t getBits(uint8_t count);
+
+	uint32_t bitBuffer;
+	uint8_t bitCount;
+	uint32_t byteCount;
+	uint32_t modelSum;
+	uint16_t modelCount;
+	void (*writeByte)(uint8_t);
+	uint8_t (*readByte)(void);
+};
+
+#endif
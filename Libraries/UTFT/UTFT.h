@@ -89,6 +89,7 @@
 #define VGA_TRANSPARENT	0xFFFFFFFF
 
 #include "Arduino.h"
+#include "DMAChannel.h"
 #include "../SPI/SPI.h"
 
 #define swap(type, i, j) {type t = i; i = j; j = t;}
@@ -190,6 +191,9 @@ public:
 	bool writeToImage = false;
 	int imageX, imageY;
 
+	//DMA settings for writeScreen, CPU transfer if not set
+	DMASetting* dmaSettings = NULL;
+
 	char		imgbuf[160];
 	byte __p1, __p2, __p3, __p4;
 	byte fch, fcl, bch, bcl;
@@ -264,6 +268,11 @@ public:
 	//Write RGB565 data to the screen
 	void writeScreen(unsigned short *pcolors)
 	{
+		//Use the DMA transfer if available
+		if (dmaSettings != NULL) {
+			writeScreenDMA(pcolors);
+			return;
+		}
 		SPI.beginTransaction(SPISettings(SPICLOCK, MSBFIRST, SPI_MODE0));
 		setAddr(0, 0, 319, 239);
 		writecommand_cont(ILI9341_RAMWR);
@@ -336,6 +345,68 @@ private:
 
 	uint8_t pcs_data, pcs_command;
 
+	//DMA channel and two line buffers with the SPI commands for writeScreen
+	DMAChannel dmaChannel;
+	uint32_t dmaLine[2][320];
+	uint32_t dmaLast;
+
+	//Write RGB565 data to the screen, the DMA sends one line while the next is upscaled
+	void writeScreenDMA(unsigned short *pcolors)
+	{
+		uint32_t* line;
+		SPI.beginTransaction(SPISettings(SPICLOCK, MSBFIRST, SPI_MODE0));
+		setAddr(0, 0, 319, 239);
+		writecommand_cont(ILI9341_RAMWR);
+		uint32_t mcr = SPI0_MCR;
+		//Let the SPI request DMA transfers when there is space in the FIFO
+		dmaChannel.triggerAtHardwareEvent(DMAMUX_SOURCE_SPI0_TX);
+		KINETISK_SPI0.RSER = SPI_RSER_TFFF_RE | SPI_RSER_TFFF_DIRS;
+		for (byte y = 0; y < 120; y++) {
+			line = dmaLine[y & 1];
+			//Upscale the row, every pixel twice
+			for (uint16_t x = 0; x < 320; x += 2) {
+				line[x] = *pcolors++ | (pcs_data << 16) | SPI_PUSHR_CTAS(1) | SPI_PUSHR_CONT;
+				line[x + 1] = line[x];
+			}
+			//Wait until the previous line has been sent
+			if (y != 0) {
+				while (!dmaChannel.complete());
+				dmaChannel.clearComplete();
+			}
+			//Send the line two times for the vertical upscale
+			dmaSettings[0].sourceBuffer(line, 1280);
+			dmaSettings[0].destination(KINETISK_SPI0.PUSHR);
+			dmaSettings[0].replaceSettingsOnCompletion(dmaSettings[1]);
+			dmaSettings[1].sourceBuffer(line, 1280);
+			dmaSettings[1].destination(KINETISK_SPI0.PUSHR);
+			//Rebuild the second pass, the last line of the previous frame has chained it
+			if (y != 119) {
+				dmaSettings[1].transferCount(320);
+				dmaSettings[1].TCD->DLASTSGA = 0;
+				dmaSettings[1].TCD->CSR = DMA_TCD_CSR_DREQ;
+			}
+			//The last pixel of the screen ends the queue
+			else {
+				dmaSettings[1].transferCount(319);
+				dmaSettings[1].TCD->CSR = 0;
+				dmaSettings[1].replaceSettingsOnCompletion(dmaSettings[2]);
+				dmaLast = (line[319] & ~SPI_PUSHR_CONT) | SPI_PUSHR_EOQ;
+				dmaSettings[2].source(dmaLast);
+				dmaSettings[2].destination(KINETISK_SPI0.PUSHR);
+				dmaSettings[2].transferCount(1);
+				dmaSettings[2].disableOnCompletion();
+			}
+			dmaChannel = dmaSettings[0];
+			dmaChannel.enable();
+		}
+		//Wait for the last line
+		while (!dmaChannel.complete());
+		dmaChannel.clearComplete();
+		KINETISK_SPI0.RSER = 0;
+		waitTransmitComplete(mcr);
+		SPI.endTransaction();
+	}
+
 	void setAddr(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
 		__attribute__((always_inline)) {
 		writecommand_cont(ILI9341_CASET); // Column addr set
@@ -0,0 +1,114 @@
+/*
+*
+* HOST - Check macro and Arduino stand-ins for the host tests
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#ifndef Host_h
+#define Host_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+//Structures shared with the firmware
+#include "../General/GlobalTypes.h"
+
+/* Defines */
+
+//Counts the check and prints it if failed, the test goes on
+#define CHECK(condition) do { \
+	hostChecks++; \
+	if (!(condition)) { \
+		hostFailures++; \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+	} \
+} while (0)
+
+/* Variables */
+
+typedef uint8_t byte;
+
+//Number of checks and failed checks
+static uint32_t hostChecks = 0;
+static uint32_t hostFailures = 0;
+
+/* Methods */
+
+/* Print the summary of the test, returns the exit code */
+static inline int hostResult(const char* name) {
+	printf("%s: %u checks, %u failed\n", name, (unsigned)hostChecks, (unsigned)hostFailures);
+	return (hostFailures == 0) ? 0 : 1;
+}
+
+/* Microseconds since the first call */
+static inline uint32_t micros() {
+	static std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Milliseconds since the first call */
+static inline uint32_t millis() {
+	return micros() / 1000;
+}
+
+/* Arduino string, only what the firmware parts on the host use */
+class String {
+public:
+	String(const char* value = "") : text(value) {}
+	void trim() {
+		text.erase(0, text.find_first_not_of(" \t\r\n"));
+		text.erase(text.find_last_not_of(" \t\r\n") + 1);
+	}
+	void toCharArray(char* buffer, unsigned int size) {
+		strncpy(buffer, text.c_str(), size - 1);
+		buffer[size - 1] = 0;
+	}
+	std::string text;
+};
+
+/* Serial port, prints to the console, reads a preset input and keeps the written bytes */
+class HostSerial {
+public:
+	void print(const char* value) { printf("%s", value); }
+	void print(int value) { printf("%d", value); }
+	void print(unsigned int value) { printf("%u", value); }
+	void print(long value) { printf("%ld", value); }
+	void print(unsigned long value) { printf("%lu", value); }
+	void print(double value, int digits = 2) { printf("%.*f", digits, value); }
+	template<typename T> void println(T value) {
+		print(value);
+		printf("\n");
+	}
+	int available() { return input.size(); }
+	String readString() {
+		String value(input.c_str());
+		input.clear();
+		return value;
+	}
+	size_t write(uint8_t value) {
+		output.push_back(value);
+		return 1;
+	}
+	size_t write(const uint8_t* data, size_t length) {
+		output.append((const char*)data, length);
+		return length;
+	}
+	std::string input;
+	//Everything written, for the tests of the serial frames
+	std::string output;
+};
+static HostSerial Serial;
+
+#endif
@@ -0,0 +1,191 @@
+/*
+*
+* LEPTON CRC TEST - Checks the VoSPI packet CRC against fixtures and a bitwise reference
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#include "Host.h"
+#include "../Hardware/LeptonCRC.h"
+
+/* Variables */
+
+//Packets in the VoSPI layout of the datasheet. Their CRCs come from binascii.crc_hqx
+//of Python, with the ID nibble and the CRC field as zero, not from this firmware
+
+//Lepton2 video packet, line 0
+const byte leptonFixtureLine0[164] = {
+	0x00, 0x00, 0x6D, 0x93, 0x1E, 0xDD, 0x1E, 0xD9, 0x1E, 0xDA, 0x1E, 0xD6, 0x1E, 0xDD, 0x1E, 0xDE,
+	0x1E, 0xD4, 0x1E, 0xD7, 0x1E, 0xD6, 0x1E, 0xD5, 0x1E, 0xDB, 0x1E, 0xDB, 0x1E, 0xD6, 0x1E, 0xD9,
+	0x1E, 0xD7, 0x1E, 0xD7, 0x1E, 0xDB, 0x1E, 0xD9, 0x1E, 0xDB, 0x1E, 0xD9, 0x1E, 0xDA, 0x1E, 0xD9,
+	0x1E, 0xDE, 0x1E, 0xDE, 0x1E, 0xE3, 0x1E, 0xDD, 0x1E, 0xD9, 0x1E, 0xE3, 0x1E, 0xE3, 0x1E, 0xE1,
+	0x1E, 0xDC, 0x1E, 0xDD, 0x1E, 0xE3, 0x1E, 0xE4, 0x1E, 0xDA, 0x1E, 0xDE, 0x1E, 0xE4, 0x1E, 0xDE,
+	0x1E, 0xE1, 0x1E, 0xE0, 0x1E, 0xDC, 0x1E, 0xE6, 0x1E, 0xE2, 0x1E, 0xDD, 0x1E, 0xE1, 0x1E, 0xE4,
+	0x1E, 0xDE, 0x1E, 0xDF, 0x1E, 0xE6, 0x1E, 0xE7, 0x1E, 0xDE, 0x1E, 0xE4, 0x1E, 0xE8, 0x1E, 0xE2,
+	0x1E, 0xE4, 0x1E, 0xE9, 0x1E, 0xE3, 0x1E, 0xE5, 0x1E, 0xE0, 0x1E, 0xE6, 0x1E, 0xE9, 0x1E, 0xE1,
+	0x1E, 0xE5, 0x1E, 0xE8, 0x1E, 0xED, 0x1E, 0xED, 0x1E, 0xE7, 0x1E, 0xEC, 0x1E, 0xE8, 0x1E, 0xE5,
+	0x1E, 0xED, 0x1E, 0xE7, 0x1E, 0xEF, 0x1E, 0xE4, 0x1E, 0xED, 0x1E, 0xEF, 0x1E, 0xEE, 0x1E, 0xE5,
+	0x1E, 0xEE, 0x1E, 0xF0 };
+
+//Lepton2 video packet, line 31 with a warm object
+const byte leptonFixtureLine31[164] = {
+	0x00, 0x1F, 0x02, 0xD6, 0x1E, 0xDD, 0x1E, 0xDC, 0x1E, 0xD9, 0x1E, 0xDA, 0x1E, 0xD5, 0x1E, 0xD7,
+	0x1E, 0xD6, 0x1E, 0xDB, 0x1E, 0xDB, 0x1E, 0xDC, 0x1E, 0xDD, 0x1E, 0xD4, 0x1E, 0xD6, 0x1E, 0xD5,
+	0x1E, 0xDE, 0x1E, 0xD8, 0x1E, 0xDA, 0x1E, 0xDD, 0x1E, 0xDF, 0x1E, 0xDE, 0x1E, 0xDA, 0x1E, 0xD7,
+	0x1E, 0xDC, 0x1E, 0xDF, 0x1E, 0xE1, 0x1E, 0xE2, 0x1F, 0x19, 0x1F, 0x19, 0x1F, 0x16, 0x1F, 0x1F,
+	0x1F, 0x15, 0x1F, 0x1A, 0x1F, 0x1C, 0x1F, 0x17, 0x1F, 0x18, 0x1F, 0x20, 0x1F, 0x1B, 0x1F, 0x19,
+	0x1F, 0x19, 0x1F, 0x20, 0x1F, 0x21, 0x1F, 0x1E, 0x1F, 0x19, 0x1F, 0x1B, 0x1F, 0x1A, 0x1F, 0x23,
+	0x1F, 0x23, 0x1F, 0x21, 0x1F, 0x1A, 0x1F, 0x1F, 0x1F, 0x24, 0x1F, 0x1E, 0x1F, 0x22, 0x1F, 0x1D,
+	0x1F, 0x1D, 0x1E, 0xDF, 0x1E, 0xEB, 0x1E, 0xE7, 0x1E, 0xEA, 0x1E, 0xE2, 0x1E, 0xE3, 0x1E, 0xE9,
+	0x1E, 0xE3, 0x1E, 0xE7, 0x1E, 0xE5, 0x1E, 0xEB, 0x1E, 0xEB, 0x1E, 0xE6, 0x1E, 0xE3, 0x1E, 0xE8,
+	0x1E, 0xE9, 0x1E, 0xE5, 0x1E, 0xEB, 0x1E, 0xEF, 0x1E, 0xEF, 0x1E, 0xEB, 0x1E, 0xEA, 0x1E, 0xEF,
+	0x1E, 0xE7, 0x1E, 0xE7 };
+
+//Lepton3 video packet, line 20 with segment 3 in the ID nibble
+const byte leptonFixtureSegment3[164] = {
+	0x30, 0x14, 0x84, 0x99, 0x1F, 0x53, 0x1F, 0x57, 0x1F, 0x57, 0x1F, 0x52, 0x1F, 0x56, 0x1F, 0x50,
+	0x1F, 0x51, 0x1F, 0x4D, 0x1F, 0x50, 0x1F, 0x53, 0x1F, 0x57, 0x1F, 0x55, 0x1F, 0x56, 0x1F, 0x50,
+	0x1F, 0x50, 0x1F, 0x57, 0x1F, 0x57, 0x1F, 0x57, 0x1F, 0x54, 0x1F, 0x5B, 0x1F, 0x58, 0x1F, 0x51,
+	0x1F, 0x55, 0x1F, 0x5B, 0x1F, 0x57, 0x1F, 0x53, 0x1F, 0x5B, 0x1F, 0x5B, 0x1F, 0x56, 0x1F, 0x5B,
+	0x1F, 0x57, 0x1F, 0x92, 0x1F, 0x95, 0x1F, 0x96, 0x1F, 0x9A, 0x1F, 0x91, 0x1F, 0x91, 0x1F, 0x94,
+	0x1F, 0x9B, 0x1F, 0x97, 0x1F, 0x9C, 0x1F, 0x94, 0x1F, 0x98, 0x1F, 0x9D, 0x1F, 0x9D, 0x1F, 0x9B,
+	0x1F, 0x9A, 0x1F, 0x98, 0x1F, 0x95, 0x1F, 0x9C, 0x1F, 0x59, 0x1F, 0x62, 0x1F, 0x60, 0x1F, 0x5F,
+	0x1F, 0x5A, 0x1F, 0x5F, 0x1F, 0x5D, 0x1F, 0x63, 0x1F, 0x5D, 0x1F, 0x5D, 0x1F, 0x60, 0x1F, 0x65,
+	0x1F, 0x5D, 0x1F, 0x5F, 0x1F, 0x65, 0x1F, 0x63, 0x1F, 0x5C, 0x1F, 0x62, 0x1F, 0x60, 0x1F, 0x67,
+	0x1F, 0x63, 0x1F, 0x60, 0x1F, 0x62, 0x1F, 0x61, 0x1F, 0x62, 0x1F, 0x5E, 0x1F, 0x66, 0x1F, 0x67,
+	0x1F, 0x69, 0x1F, 0x5F };
+
+//Discard packet, ID xFxx and random content
+const byte leptonFixtureDiscard[164] = {
+	0x0F, 0xFF, 0x01, 0x44, 0xE7, 0x04, 0xA0, 0xD8, 0xFF, 0x49, 0x15, 0xDB, 0x68, 0xCA, 0xC4, 0x48,
+	0x41, 0xE4, 0x15, 0xF0, 0xD2, 0x65, 0xDC, 0x7B, 0x9E, 0xEB, 0x20, 0x13, 0x25, 0x29, 0x05, 0xE5,
+	0x16, 0xC8, 0xC3, 0xCA, 0xBC, 0xCA, 0x08, 0xAD, 0xB4, 0x9D, 0xB5, 0xBB, 0xDE, 0x13, 0x94, 0xC2,
+	0xA5, 0x85, 0x48, 0x6D, 0xDE, 0xC4, 0xF7, 0xC7, 0xB5, 0xF0, 0xF2, 0x88, 0x4B, 0x77, 0x74, 0x9C,
+	0x18, 0x96, 0x2E, 0x5A, 0xD9, 0x55, 0x7A, 0x82, 0x55, 0xC3, 0xBB, 0x52, 0xF5, 0x41, 0xE8, 0xE7,
+	0x0D, 0x85, 0xA3, 0xA1, 0x15, 0x19, 0x7F, 0x5B, 0x5F, 0x9B, 0x08, 0xF5, 0x16, 0x50, 0x7A, 0xFA,
+	0x67, 0x61, 0x63, 0x98, 0x6A, 0xD1, 0xC3, 0x1F, 0x2B, 0xAF, 0xB6, 0x74, 0x1D, 0xCF, 0x70, 0x39,
+	0xE3, 0x06, 0x8B, 0x21, 0xF5, 0x4D, 0xA0, 0x3F, 0x03, 0x7F, 0x77, 0x68, 0x14, 0xB1, 0xAB, 0x28,
+	0x72, 0x16, 0x24, 0x88, 0xC4, 0xE1, 0x42, 0x7A, 0x24, 0xFA, 0x0E, 0xB3, 0x52, 0x9C, 0x61, 0x80,
+	0x0B, 0x04, 0xA2, 0x04, 0x16, 0xBE, 0xEB, 0xAE, 0x42, 0xC2, 0xAD, 0x00, 0x09, 0xE7, 0xF5, 0xED,
+	0x4C, 0xCE, 0x20, 0xB2 };
+
+//Expected CRC of the packets
+const uint16_t leptonFixtureCRC[4] = { 0x6D93, 0x02D6, 0x8499, 0x0144 };
+
+/* Methods */
+
+/* CRC16-CCITT bit by bit, polynomial 0x1021 and seed zero */
+uint16_t referenceCRC(const byte* data, uint16_t length) {
+	uint16_t crc = 0;
+	for (uint16_t i = 0; i < length; i++) {
+		crc ^= data[i] << 8;
+		for (byte bit = 0; bit < 8; bit++)
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+	}
+	return crc;
+}
+
+/* Build a VoSPI packet with the CRC the Lepton would send */
+void buildPacket(byte* packet, byte segment, byte line, uint16_t base) {
+	//Line number and the segment in the upper nibble
+	packet[0] = segment << 4;
+	packet[1] = line;
+	//80 values of 14 bit, MSB first
+	for (byte i = 0; i < 80; i++) {
+		uint16_t value = base + ((i * 37 + line * 11) % 97);
+		packet[4 + (i * 2)] = value >> 8;
+		packet[5 + (i * 2)] = value & 0xFF;
+	}
+	//CRC over the packet with the ID nibble and the CRC field as zero
+	byte copy[164];
+	memcpy(copy, packet, 164);
+	copy[0] &= 0x0F;
+	copy[2] = 0;
+	copy[3] = 0;
+	uint16_t crc = referenceCRC(copy, 164);
+	packet[2] = crc >> 8;
+	packet[3] = crc & 0xFF;
+}
+
+/* Same comparison as leptonCheckCRC */
+bool packetValid(const byte* packet) {
+	return leptonCRC(packet) == ((packet[2] << 8) | packet[3]);
+}
+
+int main() {
+	byte packet[164];
+
+	//Reference against the standard check value of CRC16-CCITT with seed zero
+	CHECK(referenceCRC((const byte*)"123456789", 9) == 0x31C3);
+
+	//Every table entry is the CRC of its index
+	for (uint16_t i = 0; i < 256; i++) {
+		byte value = i;
+		CHECK(leptonCRCTable[i] == referenceCRC(&value, 1));
+	}
+
+	//Fixtures with the CRC of the independent implementation
+	const byte* fixtures[4] = { leptonFixtureLine0, leptonFixtureLine31, leptonFixtureSegment3, leptonFixtureDiscard };
+	for (byte i = 0; i < 4; i++) {
+		CHECK(leptonCRC(fixtures[i]) == leptonFixtureCRC[i]);
+		CHECK(packetValid(fixtures[i]));
+	}
+	//Only the discard packet is sorted out by its ID before the CRC check
+	for (byte i = 0; i < 3; i++)
+		CHECK((fixtures[i][0] & 0x0F) != 0x0F);
+	CHECK((leptonFixtureDiscard[0] & 0x0F) == 0x0F);
+	//A bit error in the fixture is detected
+	memcpy(packet, leptonFixtureSegment3, 164);
+	packet[100] ^= 0x04;
+	CHECK(!packetValid(packet));
+
+	//Valid packets of a Lepton2 frame
+	for (byte line = 0; line < 60; line++) {
+		buildPacket(packet, 0, line, 7900);
+		CHECK(packetValid(packet));
+	}
+	//Lepton3 line 20 carries the segment, it does not count for the CRC
+	for (byte segment = 1; segment <= 4; segment++) {
+		buildPacket(packet, segment, 20, 8100);
+		CHECK(packetValid(packet));
+	}
+	//Extreme values
+	buildPacket(packet, 0, 59, 0x3FFF - 96);
+	CHECK(packetValid(packet));
+	buildPacket(packet, 0, 0, 0);
+	CHECK(packetValid(packet));
+
+	//Every single bit error outside the ID nibble is detected
+	buildPacket(packet, 0, 31, 8000);
+	for (uint16_t bit = 4; bit < (164 * 8); bit++) {
+		packet[bit / 8] ^= 0x80 >> (bit % 8);
+		CHECK(!packetValid(packet));
+		packet[bit / 8] ^= 0x80 >> (bit % 8);
+	}
+	CHECK(packetValid(packet));
+
+	//Two different values swapped
+	byte swapped[164];
+	memcpy(swapped, packet, 164);
+	memcpy(&swapped[10], &packet[12], 2);
+	memcpy(&swapped[12], &packet[10], 2);
+	CHECK(memcmp(swapped, packet, 164) != 0);
+	CHECK(!packetValid(swapped));
+
+	//Packet from another line with the CRC of this one
+	byte other[164];
+	buildPacket(other, 0, 32, 8000);
+	other[2] = packet[2];
+	other[3] = packet[3];
+	CHECK(!packetValid(other));
+
+	return hostResult("LeptonCRCTest");
+}
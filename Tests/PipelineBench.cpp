@@ -0,0 +1,159 @@
+/*
+*
+* PIPELINE BENCH - Times the frame pipeline stages on the host
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#include "Host.h"
+#include "RawCodec.h"
+#include "../General/GlobalDefines.h"
+#include "../General/ColorSchemes.h"
+
+/* Variables */
+
+//Firmware variables used by the stages, same as in GlobalVariables.h
+const byte* colorMap;
+int16_t colorElements;
+uint16_t colorLUT[256];
+uint16_t colorLUTCount;
+unsigned short image[19200] __attribute__((aligned(4)));
+bool imageNative = false;
+byte leptonVersion = leptonVersion_3_Shutter;
+byte displayMode = displayMode_thermal;
+uint16_t maxTemp;
+uint16_t minTemp;
+uint16_t minTempPos;
+uint16_t maxTempPos;
+FrameStats frameStats;
+byte hotColdMode = hotColdMode_disabled;
+int16_t hotColdLevel = 0;
+byte hotColdColor = 0;
+byte calStatus = cal_standard;
+float calOffset = 0;
+float calSlope = cal_stdSlope;
+float adjCombAlpha = 0.5;
+byte adjCombLeft = 2;
+byte adjCombRight = 2;
+byte adjCombUp = 2;
+byte adjCombDown = 2;
+//VoSPI statistics, nothing is received on the host
+uint32_t leptonDiscards = 0;
+uint32_t leptonSyncLosses = 0;
+uint32_t leptonResets = 0;
+uint32_t leptonCRCErrors = 0;
+
+RawCodec rawCodec;
+//Content of the recorded frame
+byte fileBuffer[19200 * 3];
+uint32_t filePos;
+uint32_t fileLen;
+//State of the noise generator
+uint32_t randomState = 12345;
+
+/* Methods */
+
+/* Raw value of a temperature, the hot / cold mode is disabled here */
+uint16_t tempToRaw(float temp) {
+	return (temp - calOffset) / calSlope;
+}
+
+/* Noise of the synthetic frames */
+uint16_t randomValue() {
+	randomState = (randomState * 1103515245) + 12345;
+	return randomState >> 16;
+}
+
+/* Synthetic scene instead of the Lepton, native Lepton2 or Lepton3 */
+void getLeptonImage() {
+	imageNative = (leptonVersion != leptonVersion_3_Shutter);
+	byte width = imageNative ? 80 : 160;
+	byte height = imageNative ? 60 : 120;
+	for (byte y = 0; y < height; y++) {
+		for (byte x = 0; x < width; x++) {
+			//Gradient, noise and a warm object in the middle
+			int16_t dx = x - (width / 2);
+			int16_t dy = y - (height / 2);
+			uint16_t value = 7800 + x + y + (randomValue() % 16);
+			if (((dx * dx) + (dy * dy)) < ((width * width) / 16))
+				value += 400;
+			image[(y * width) + x] = value;
+		}
+	}
+}
+
+/* Read function of the codec */
+uint8_t fileRead() {
+	return (filePos < fileLen) ? fileBuffer[filePos++] : 0;
+}
+
+/* Reads the frame of a .DAT file from the host instead of the SD card */
+void loadRawData(char* filename, char* dirname = NULL) {
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL) {
+		printf("Can not open %s, using a synthetic frame\n", filename);
+		getLeptonImage();
+		return;
+	}
+	fileLen = fread(fileBuffer, 1, sizeof(fileBuffer), file);
+	fclose(file);
+	filePos = 0;
+
+	//Compressed frame, the flags tell the sensor
+	bool lepton3 = (fileLen >= 38400);
+	if ((fileLen > 2) && (fileBuffer[0] == RAWCODEC_MARKER)) {
+		lepton3 = fileBuffer[1] & RAWCODEC_LEPTON3;
+		filePos = 2;
+		rawCodec.decode(image, lepton3 ? 160 : 80, lepton3 ? 120 : 60, fileRead);
+	}
+	//Raw values MSB first
+	else {
+		for (uint16_t i = 0; i < (lepton3 ? 19200 : 4800); i++)
+			image[i] = (fileRead() << 8) | fileRead();
+	}
+	leptonVersion = lepton3 ? leptonVersion_3_Shutter : leptonVersion_2_Shutter;
+	imageNative = !lepton3;
+}
+
+/* The color scheme is fixed on the host */
+void selectColorScheme() {
+	colorMap = colorMap_rainbow;
+	colorElements = 256;
+}
+
+/* Nothing to restore on the host */
+void readEEPROM() {
+}
+
+#include "../Thermal/Pipeline.h"
+#include "../Thermal/Benchmark.h"
+
+int main(int argc, char** argv) {
+	selectColorScheme();
+
+	//Synthetic Lepton3 frames
+	printf("Synthetic Lepton3 frames\n");
+	leptonVersion = leptonVersion_3_Shutter;
+	benchmarkPipeline();
+
+	//Synthetic Lepton2 frames in the native size
+	printf("Synthetic Lepton2 frames\n");
+	leptonVersion = leptonVersion_2_Shutter;
+	benchmarkPipeline();
+
+	//Recorded frame, replayed like on the device
+	if (argc > 1) {
+		printf("Recorded frame %s\n", argv[1]);
+		Serial.input = argv[1];
+		benchmarkPipeline();
+	}
+	return 0;
+}
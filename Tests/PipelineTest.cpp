@@ -0,0 +1,158 @@
+/*
+*
+* PIPELINE TEST - Checks the color conversion against the per pixel calculation
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#include "Host.h"
+#include "../General/GlobalDefines.h"
+#include "../General/ColorSchemes.h"
+
+/* Variables */
+
+//Firmware variables used by the stages, same as in GlobalVariables.h
+const byte* colorMap;
+int16_t colorElements;
+uint16_t colorLUT[256];
+uint16_t colorLUTCount;
+unsigned short image[19200] __attribute__((aligned(4)));
+bool imageNative = false;
+byte displayMode = displayMode_thermal;
+uint16_t maxTemp;
+uint16_t minTemp;
+uint16_t minTempPos;
+uint16_t maxTempPos;
+FrameStats frameStats;
+byte hotColdMode = hotColdMode_disabled;
+int16_t hotColdLevel = 0;
+byte hotColdColor = hotColdColor_white;
+byte calStatus = cal_standard;
+float adjCombAlpha = 0.5;
+byte adjCombLeft = 2;
+byte adjCombRight = 2;
+byte adjCombUp = 2;
+byte adjCombDown = 2;
+
+//Values of the test frame, outside of the limits on both sides
+uint16_t frameValues[19200];
+
+/* Methods */
+
+/* Raw value and temperature are the same in the test */
+uint16_t tempToRaw(float temp) {
+	return temp;
+}
+
+#include "../Thermal/Pipeline.h"
+
+/* Color of one pixel, calculated like before the lookup table */
+uint16_t referenceColor(uint16_t value, int16_t elements) {
+	byte red, green, blue;
+	//Hot
+	if ((hotColdMode == hotColdMode_hot) && (value >= hotColdLevel))
+		getHotColdColors(&red, &green, &blue);
+	//Cold
+	else if ((hotColdMode == hotColdMode_cold) && (value <= hotColdLevel))
+		getHotColdColors(&red, &green, &blue);
+	//Apply colorscheme
+	else {
+		if (value > maxTemp)
+			value = maxTemp;
+		if (value < minTemp)
+			value = minTemp;
+		uint16_t index = (value - minTemp) * ((elements - 1.0) / (maxTemp - minTemp));
+		//Shortened full scheme, see buildColorLUT
+		index = (index * (colorElements - 1)) / (elements - 1);
+		red = colorMap[3 * index];
+		green = colorMap[3 * index + 1];
+		blue = colorMap[3 * index + 2];
+	}
+	return colorToRGB565(red, green, blue);
+}
+
+/* Fill the image with the test frame, native Lepton2 or full size */
+void fillImage(bool native) {
+	imageNative = native;
+	memcpy(image, frameValues, (native ? 4800 : 19200) * 2);
+}
+
+/* Convert colors and indices for one setting and compare every pixel */
+void checkSetting(byte mode, int16_t level, bool native) {
+	hotColdMode = mode;
+	hotColdLevel = level;
+	int16_t elements = colorElements;
+	if ((mode != hotColdMode_disabled) && (elements == 256))
+		elements = 255;
+
+	//RGB565 colors, the native image is upscaled
+	fillImage(native);
+	convertColors();
+	uint32_t errors = 0;
+	for (uint16_t i = 0; i < 19200; i++) {
+		uint16_t value = native ? frameValues[((i / 320) * 80) + ((i % 160) / 2)] : frameValues[i];
+		if (image[i] != referenceColor(value, elements))
+			errors++;
+	}
+	CHECK(errors == 0);
+
+	//Color indices and the palette
+	fillImage(native);
+	convertIndices();
+	byte* indices = (byte*)image;
+	errors = 0;
+	for (uint16_t i = 0; i < (native ? 4800 : 19200); i++) {
+		if ((indices[i] >= colorLUTCount) || (colorLUT[indices[i]] != referenceColor(frameValues[i], elements)))
+			errors++;
+	}
+	CHECK(errors == 0);
+}
+
+/* All hot / cold modes with the level below, inside and above the limits */
+void testScheme(const byte* map, int16_t elements) {
+	colorMap = map;
+	colorElements = elements;
+	const int16_t levels[] = { 7300, 7500, 7999, 8000, 8001, 8500, 8700 };
+	for (byte native = 0; native < 2; native++) {
+		checkSetting(hotColdMode_disabled, 0, native);
+		for (byte i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+			checkSetting(hotColdMode_hot, levels[i], native);
+			checkSetting(hotColdMode_cold, levels[i], native);
+		}
+	}
+}
+
+/* Pixels next to the level share its color index, only the raw value decides */
+void testSameIndex() {
+	colorMap = colorMap_arctic;
+	colorElements = 240;
+	hotColdMode = hotColdMode_hot;
+	hotColdLevel = 8001;
+	fillImage(false);
+	image[0] = 8000;
+	image[1] = 8001;
+	convertColors();
+	CHECK(image[0] != colorToRGB565(255, 255, 255));
+	CHECK(image[1] == colorToRGB565(255, 255, 255));
+}
+
+int main() {
+	//Gradient with manual limits, values outside on both sides
+	for (uint16_t i = 0; i < 19200; i++)
+		frameValues[i] = 7000 + (i % 2001);
+	minTemp = 7500;
+	maxTemp = 8500;
+
+	testScheme(colorMap_arctic, 240);
+	testScheme(colorMap_rainbow, 256);
+	testSameIndex();
+	return hostResult("PipelineTest");
+}
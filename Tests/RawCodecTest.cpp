@@ -0,0 +1,253 @@
+/*
+*
+* RAW CODEC TEST - Encodes and decodes frames, they must come back exactly
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#include <stdlib.h>
+#include "Host.h"
+#include "RawCodec.h"
+
+/* Variables */
+
+RawCodec rawCodec;
+//Compressed data, large enough for the worst case of a full frame
+byte stream[19200 * 6];
+uint32_t streamPos;
+uint32_t streamLen;
+
+//Source frame, reference frame and decoded frame
+uint16_t frame[19200];
+uint16_t reference[19200];
+uint16_t decoded[19200];
+
+/* Methods */
+
+/* Write function of the encoder */
+void streamWrite(uint8_t value) {
+	if (streamLen < sizeof(stream))
+		stream[streamLen] = value;
+	streamLen++;
+}
+
+/* Read function of the decoder, zero behind the end */
+uint8_t streamRead() {
+	if (streamPos < streamLen)
+		return stream[streamPos++];
+	streamPos++;
+	return 0;
+}
+
+/* Random value from a simple generator, the results are the same on every host */
+uint32_t randomState = 12345;
+uint16_t randomValue() {
+	randomState = (randomState * 1103515245) + 12345;
+	return randomState >> 16;
+}
+
+/* Encodes width x height values of the layout, decodes them and compares */
+void roundTrip(const char* name, const uint16_t* image, uint16_t width, uint16_t height,
+	uint8_t pixelStep, uint16_t lineStep) {
+	uint32_t size = rawCodec.encode(image, width, height, pixelStep, lineStep, NULL);
+	streamLen = 0;
+	uint32_t written = rawCodec.encode(image, width, height, pixelStep, lineStep, streamWrite);
+	//The size calculation matches the written bytes
+	CHECK(size == written);
+	CHECK(streamLen == written);
+	CHECK(written <= sizeof(stream));
+
+	memset(decoded, 0xAA, sizeof(decoded));
+	streamPos = 0;
+	rawCodec.decode(decoded, width, height, streamRead);
+	//All bytes used, nothing read behind the end
+	CHECK(streamPos == streamLen);
+	uint32_t errors = 0;
+	for (uint16_t y = 0; y < height; y++)
+		for (uint16_t x = 0; x < width; x++)
+			if (decoded[(y * width) + x] != image[(y * lineStep) + (x * pixelStep)])
+				errors++;
+	CHECK(errors == 0);
+	if (errors != 0)
+		printf("%s: %u of %u values differ\n", name, (unsigned)errors, (unsigned)(width * height));
+	printf("%-28s %3ux%-3u %6u -> %6u bytes\n", name, width, height,
+		(unsigned)(width * height * 2), (unsigned)written);
+}
+
+/* Encodes the difference to the reference, decodes it and compares */
+void deltaTrip(const char* name, uint16_t count) {
+	uint32_t size = rawCodec.encodeDelta(frame, reference, count, NULL);
+	streamLen = 0;
+	uint32_t written = rawCodec.encodeDelta(frame, reference, count, streamWrite);
+	CHECK(size == written);
+	CHECK(streamLen == written);
+
+	//Decode in place over the reference, like the viewer does
+	memcpy(decoded, reference, count * 2);
+	streamPos = 0;
+	rawCodec.decodeDelta(decoded, decoded, count, streamRead);
+	CHECK(streamPos == streamLen);
+	CHECK(memcmp(decoded, frame, count * 2) == 0);
+	printf("%-28s %7u -> %6u bytes\n", name, (unsigned)(count * 2), (unsigned)written);
+}
+
+/* Runs the compact, strided and delta round trips over the frame */
+void testFrame(const char* name, uint16_t width, uint16_t height) {
+	char label[64];
+	uint16_t count = width * height;
+	roundTrip(name, frame, width, height, 1, width);
+
+	//Every second value of every second line, like Lepton2 upscaled to 160x120
+	if (width == 160) {
+		snprintf(label, sizeof(label), "%s, step 2", name);
+		roundTrip(label, frame, 80, 60, 2, 320);
+	}
+	//Region of interest with decimation
+	snprintf(label, sizeof(label), "%s, region", name);
+	roundTrip(label, &frame[(5 * width) + 7], (width - 20) / 3, (height - 10) / 3, 3, width * 3);
+	//Single line and single column
+	snprintf(label, sizeof(label), "%s, line", name);
+	roundTrip(label, frame, width, 1, 1, width);
+	snprintf(label, sizeof(label), "%s, column", name);
+	roundTrip(label, frame, 1, height, 1, width);
+
+	//Difference to a noisy copy, to itself and to a frame full of extremes
+	for (uint16_t i = 0; i < count; i++)
+		reference[i] = (frame[i] + (randomValue() % 9) - 4) & 0x3FFF;
+	snprintf(label, sizeof(label), "%s, delta", name);
+	deltaTrip(label, count);
+	memcpy(reference, frame, count * 2);
+	snprintf(label, sizeof(label), "%s, delta same", name);
+	deltaTrip(label, count);
+	//The estimate prefers the delta frame for an unchanged scene
+	CHECK(rawCodec.costDelta(frame, reference, width, height) == 0);
+	CHECK(rawCodec.cost(frame, width, height, 1, width) >= rawCodec.costDelta(frame, reference, width, height));
+	for (uint16_t i = 0; i < count; i++)
+		reference[i] = (i & 1) ? 0x3FFF : 0;
+	snprintf(label, sizeof(label), "%s, delta extremes", name);
+	deltaTrip(label, count);
+}
+
+/* Fills the frame with a synthetic scene, 14 bit like the Lepton */
+void fillScene(uint16_t width, uint16_t height) {
+	for (uint16_t y = 0; y < height; y++) {
+		for (uint16_t x = 0; x < width; x++) {
+			//Background gradient with sensor noise
+			uint16_t value = 7800 + ((x * 120) / width) + ((y * 60) / height) + (randomValue() % 7);
+			//Warm object with a hot spot in the middle
+			int16_t dx = x - (width / 2);
+			int16_t dy = y - (height / 2);
+			uint16_t distance = (dx * dx) + (dy * dy);
+			if (distance < ((width * width) / 16))
+				value += 400;
+			if (distance < 4)
+				value = 12000;
+			frame[(y * width) + x] = value;
+		}
+	}
+}
+
+/* Runs the synthetic frames for one resolution */
+void testSynthetic(uint16_t width, uint16_t height) {
+	char name[64];
+	uint16_t count = width * height;
+
+	//All equal, the smallest and the largest 14 bit value
+	for (uint16_t i = 0; i < count; i++)
+		frame[i] = 0;
+	snprintf(name, sizeof(name), "%ux%u zero", width, height);
+	testFrame(name, width, height);
+	for (uint16_t i = 0; i < count; i++)
+		frame[i] = 0x3FFF;
+	snprintf(name, sizeof(name), "%ux%u 0x3FFF", width, height);
+	testFrame(name, width, height);
+
+	//Checkerboard of both extremes, every residual takes the escape
+	for (uint16_t y = 0; y < height; y++)
+		for (uint16_t x = 0; x < width; x++)
+			frame[(y * width) + x] = ((x + y) & 1) ? 0x3FFF : 0;
+	snprintf(name, sizeof(name), "%ux%u checkerboard", width, height);
+	testFrame(name, width, height);
+
+	//Flat frame with single extremes, escape after a small Rice parameter
+	for (uint16_t i = 0; i < count; i++)
+		frame[i] = ((i % 97) == 0) ? 0x3FFF : (((i % 89) == 0) ? 0 : 8000);
+	snprintf(name, sizeof(name), "%ux%u spikes", width, height);
+	testFrame(name, width, height);
+
+	//Random 14 bit and 16 bit values
+	for (uint16_t i = 0; i < count; i++)
+		frame[i] = randomValue() & 0x3FFF;
+	snprintf(name, sizeof(name), "%ux%u noise 14 bit", width, height);
+	testFrame(name, width, height);
+	for (uint16_t i = 0; i < count; i++)
+		frame[i] = randomValue();
+	snprintf(name, sizeof(name), "%ux%u noise 16 bit", width, height);
+	testFrame(name, width, height);
+
+	//Scene with gradient, noise and a hot object
+	fillScene(width, height);
+	snprintf(name, sizeof(name), "%ux%u scene", width, height);
+	testFrame(name, width, height);
+}
+
+/* Reads the frame of a .DAT file from the SD card, compressed or not */
+bool loadFrame(const char* filename, uint16_t* width, uint16_t* height) {
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL)
+		return false;
+	streamLen = fread(stream, 1, sizeof(stream), file);
+	fclose(file);
+
+	//Compressed frame, the flags tell the sensor
+	if ((streamLen > 2) && (stream[0] == RAWCODEC_MARKER)) {
+		bool lepton3 = stream[1] & RAWCODEC_LEPTON3;
+		*width = lepton3 ? 160 : 80;
+		*height = lepton3 ? 120 : 60;
+		streamPos = 2;
+		rawCodec.decode(frame, *width, *height, streamRead);
+		return true;
+	}
+	//Raw values MSB first, Lepton3 if the file is large enough
+	if (streamLen >= 38400) {
+		*width = 160;
+		*height = 120;
+	}
+	else if (streamLen >= 9600) {
+		*width = 80;
+		*height = 60;
+	}
+	else
+		return false;
+	for (uint16_t i = 0; i < (*width * *height); i++)
+		frame[i] = (stream[i * 2] << 8) | stream[(i * 2) + 1];
+	return true;
+}
+
+int main(int argc, char** argv) {
+	//Synthetic frames of the Lepton3 and the native Lepton2
+	testSynthetic(160, 120);
+	testSynthetic(80, 60);
+
+	//Recorded frames given on the command line
+	for (int i = 1; i < argc; i++) {
+		uint16_t width, height;
+		bool loaded = loadFrame(argv[i], &width, &height);
+		CHECK(loaded);
+		if (!loaded) {
+			printf("%s: not a raw frame\n", argv[i]);
+			continue;
+		}
+		testFrame(argv[i], width, height);
+	}
+
+	return hostResult("RawCodecTest");
+}
@@ -0,0 +1,299 @@
+/*
+*
+* SERIAL FRAME TEST - Sends v2 frames and decodes them with the host decoder
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+#include "Host.h"
+#include "RawCodec.h"
+#include "FrameDecoder.h"
+#include "../General/GlobalDefines.h"
+#include "../Hardware/LeptonCRC.h"
+
+/* Variables */
+
+//Firmware variables used by the frames, same as in GlobalVariables.h
+unsigned short image[19200] __attribute__((aligned(4)));
+bool imageNative = false;
+byte leptonVersion = leptonVersion_3_Shutter;
+uint16_t maxTemp = 9000;
+uint16_t minTemp = 7000;
+FrameStats frameStats;
+float calOffset = -273.15f;
+float calSlope = cal_stdSlope;
+uint16_t showTemp[192];
+uint16_t colorLUT[256];
+uint16_t colorLUTCount = 256;
+int16_t colorElements = 256;
+byte filterType = filterType_none;
+RawCodec rawCodec;
+
+FrameDecoder decoder;
+//Raw values of the frame before sending
+uint16_t frame[19200];
+//State of the noise generator
+uint32_t randomState = 12345;
+
+/* Methods */
+
+/* The filters are tested with the pipeline */
+void boxFilter() {
+}
+void gaussianFilter() {
+}
+
+/* Simple color conversion, only the transport is tested here */
+void convertColors() {
+	for (uint16_t i = 0; i < 19200; i++)
+		image[i] = colorLUT[image[i] & 0xFF];
+	imageNative = false;
+}
+
+/* Simple index conversion, in place like the firmware */
+void convertIndices() {
+	byte* indices = (byte*)image;
+	uint16_t size = imageNative ? 4800 : 19200;
+	for (uint16_t i = 0; i < size; i++)
+		indices[i] = image[i] & 0xFF;
+}
+
+/* Float to bytes, LSB first like Save.h on the Teensy */
+void floatToBytes(uint8_t* farray, float val) {
+	memcpy(farray, &val, 4);
+}
+
+#include "../Hardware/SerialFrame.h"
+
+/* Noise of the synthetic frames */
+uint16_t randomValue() {
+	randomState = (randomState * 1103515245) + 12345;
+	return randomState >> 16;
+}
+
+/* Scene with a warm object at the position, noise of the given range */
+void fillScene(uint16_t width, uint16_t height, int16_t objectX, uint16_t noise) {
+	for (uint16_t y = 0; y < height; y++) {
+		for (uint16_t x = 0; x < width; x++) {
+			int16_t dx = x - objectX;
+			int16_t dy = y - (height / 2);
+			uint16_t value = 7800 + x + y + (randomValue() % noise);
+			if (((dx * dx) + (dy * dy)) < ((width * width) / 25))
+				value += 400;
+			frame[(y * width) + x] = value;
+		}
+	}
+	memcpy(image, frame, width * height * 2);
+}
+
+/* Sends a frame and decodes all bytes of it */
+int8_t sendAndDecode(byte format) {
+	uint32_t used;
+	Serial.output.clear();
+	sendFrameV2(format);
+	int8_t result = decoder.parse((const uint8_t*)Serial.output.data(), Serial.output.size(), &used);
+	if (result == FRAMEDECODER_FRAME)
+		CHECK(used == Serial.output.size());
+	return result;
+}
+
+/* Compressed Lepton2 frames of a static and a moving scene */
+void testLepton2Stream() {
+	uint32_t bytes = 0, deltas = 0, maxRun = 0, run = 0;
+	leptonVersion = leptonVersion_2_Shutter;
+	deltaValid = false;
+	for (uint16_t i = 0; i < 100; i++) {
+		//Static for 60 frames, then the object moves fast
+		fillScene(80, 60, (i < 60) ? 40 : (i * 7) % 80, (i < 60) ? 3 : 9);
+		imageNative = true;
+		CHECK(sendAndDecode(frameFormat_compressed) == FRAMEDECODER_FRAME);
+		CHECK((decoder.width == 80) && (decoder.height == 60));
+		CHECK(memcmp(decoder.pixels, frame, 9600) == 0);
+		bytes += Serial.output.size();
+		if (decoder.flags & frameFlag_delta) {
+			deltas++;
+			run++;
+			if (run > maxRun)
+				maxRun = run;
+		}
+		else
+			run = 0;
+	}
+	//Delta frames are used, with a keyframe after frameV2_keyInterval
+	CHECK(deltas > 0);
+	CHECK(maxRun <= frameV2_keyInterval);
+	printf("Lepton2 stream: 100 frames, %u delta, %u bytes instead of %u\n",
+		(unsigned)deltas, (unsigned)bytes, (unsigned)(100 * (9600 + frameV2_headerSize + frameV2_metaSize + 2)));
+}
+
+/* Compressed Lepton3 frames are always keyframes */
+void testLepton3Stream() {
+	leptonVersion = leptonVersion_3_Shutter;
+	for (uint16_t i = 0; i < 5; i++) {
+		fillScene(160, 120, 80, 3);
+		imageNative = false;
+		CHECK(sendAndDecode(frameFormat_compressed) == FRAMEDECODER_FRAME);
+		CHECK((decoder.width == 160) && (decoder.height == 120));
+		CHECK((decoder.flags & frameFlag_delta) == 0);
+		CHECK(memcmp(decoder.pixels, frame, 38400) == 0);
+	}
+}
+
+/* A lost frame breaks the delta chain until the next keyframe */
+void testLostFrame() {
+	uint32_t used;
+	leptonVersion = leptonVersion_2_Shutter;
+	deltaValid = false;
+	//Keyframe, then a delta frame that gets lost
+	fillScene(80, 60, 40, 2);
+	imageNative = true;
+	CHECK(sendAndDecode(frameFormat_compressed) == FRAMEDECODER_FRAME);
+	fillScene(80, 60, 40, 2);
+	Serial.output.clear();
+	sendFrameV2(frameFormat_compressed);
+	//The following delta frame is rejected
+	fillScene(80, 60, 40, 2);
+	Serial.output.clear();
+	sendFrameV2(frameFormat_compressed);
+	CHECK(Serial.output[5] & frameFlag_delta);
+	CHECK(decoder.parse((const uint8_t*)Serial.output.data(), Serial.output.size(), &used) == FRAMEDECODER_ERROR);
+	CHECK(used == Serial.output.size());
+	//Until the camera sends a keyframe again
+	deltaValid = false;
+	fillScene(80, 60, 40, 2);
+	CHECK(sendAndDecode(frameFormat_compressed) == FRAMEDECODER_FRAME);
+	CHECK(memcmp(decoder.pixels, frame, 9600) == 0);
+	fillScene(80, 60, 40, 2);
+	CHECK(sendAndDecode(frameFormat_compressed) == FRAMEDECODER_FRAME);
+	CHECK(memcmp(decoder.pixels, frame, 9600) == 0);
+}
+
+/* Broken bytes are found by the CRC, the decoder finds the next frame */
+void testCorrupted() {
+	uint32_t used;
+	leptonVersion = leptonVersion_3_Shutter;
+	fillScene(160, 120, 80, 3);
+	imageNative = false;
+	Serial.output.clear();
+	sendFrameV2(frameFormat_raw);
+	std::string data = Serial.output;
+	data[1000] ^= 0x10;
+	//Good frame behind the broken one
+	fillScene(160, 120, 60, 3);
+	Serial.output.clear();
+	sendFrameV2(frameFormat_raw);
+	data += Serial.output;
+
+	uint32_t pos = 0, frames = 0, errors = 0;
+	while (pos < data.size()) {
+		int8_t result = decoder.parse((const uint8_t*)&data[pos], data.size() - pos, &used);
+		if (result == FRAMEDECODER_MORE)
+			break;
+		if (result == FRAMEDECODER_FRAME)
+			frames++;
+		else
+			errors++;
+		pos += used;
+	}
+	CHECK(frames == 1);
+	CHECK(errors > 0);
+	CHECK(memcmp(decoder.pixels, frame, 38400) == 0);
+}
+
+/* Parts of a frame are not decoded before it is complete */
+void testPartial() {
+	uint32_t used;
+	leptonVersion = leptonVersion_3_Shutter;
+	fillScene(160, 120, 80, 3);
+	imageNative = false;
+	Serial.output.clear();
+	sendFrameV2(frameFormat_compressed);
+	const uint8_t* data = (const uint8_t*)Serial.output.data();
+	uint32_t size = Serial.output.size();
+	for (uint32_t length = 0; length < size; length += 97)
+		CHECK(decoder.parse(data, length, &used) == FRAMEDECODER_MORE);
+	CHECK(decoder.parse(data, size - 1, &used) == FRAMEDECODER_MORE);
+	CHECK(decoder.parse(data, size, &used) == FRAMEDECODER_FRAME);
+	CHECK(used == size);
+}
+
+/* Raw values of a region with decimation */
+void testRegion() {
+	leptonVersion = leptonVersion_3_Shutter;
+	fillScene(160, 120, 80, 3);
+	imageNative = false;
+	roiX = 10;
+	roiY = 5;
+	roiWidth = 50;
+	roiHeight = 40;
+	roiStep = 3;
+	CHECK(sendAndDecode(frameFormat_raw) == FRAMEDECODER_FRAME);
+	CHECK((decoder.width == 17) && (decoder.height == 14));
+	uint32_t errors = 0;
+	for (uint16_t y = 0; y < decoder.height; y++)
+		for (uint16_t x = 0; x < decoder.width; x++)
+			if (decoder.pixels[(y * decoder.width) + x] != frame[((5 + (y * 3)) * 160) + 10 + (x * 3)])
+				errors++;
+	CHECK(errors == 0);
+	//The compressed frames use the same layout
+	fillScene(160, 120, 80, 3);
+	CHECK(sendAndDecode(frameFormat_compressed) == FRAMEDECODER_FRAME);
+	CHECK(decoder.pixels[decoder.width + 1] == frame[(8 * 160) + 13]);
+	roiWidth = 0;
+	roiHeight = 0;
+	roiStep = 1;
+}
+
+/* Color and indexed frames with the palette, metadata and button events */
+void testOtherFormats() {
+	leptonVersion = leptonVersion_3_Shutter;
+	for (uint16_t i = 0; i < 256; i++)
+		colorLUT[i] = i * 251;
+	for (uint8_t i = 0; i < 192; i++)
+		showTemp[i] = i * 3;
+	frameStats.spot = 23.5f;
+
+	fillScene(160, 120, 80, 3);
+	imageNative = false;
+	CHECK(sendAndDecode(frameFormat_color) == FRAMEDECODER_FRAME);
+	CHECK(decoder.pixels[1234] == colorLUT[frame[1234] & 0xFF]);
+	CHECK((decoder.minTemp == minTemp) && (decoder.maxTemp == maxTemp));
+	CHECK((decoder.spotTemp == 23.5f) && (decoder.calSlope == calSlope) && (decoder.calOffset == calOffset));
+	CHECK(memcmp(decoder.points, showTemp, 384) == 0);
+
+	//The palette only comes with the first indexed frame
+	paletteSent = false;
+	fillScene(160, 120, 80, 3);
+	CHECK(sendAndDecode(frameFormat_indexed) == FRAMEDECODER_FRAME);
+	CHECK(decoder.flags & frameFlag_palette);
+	CHECK((decoder.paletteCount == 256) && (memcmp(decoder.palette, colorLUT, 512) == 0));
+	CHECK(decoder.indices[4321] == (frame[4321] & 0xFF));
+	fillScene(160, 120, 80, 3);
+	CHECK(sendAndDecode(frameFormat_indexed) == FRAMEDECODER_FRAME);
+	CHECK((decoder.flags & frameFlag_palette) == 0);
+
+	//Button event without content
+	sendCmd = FRAME_CAPTURE;
+	CHECK(sendAndDecode(frameFormat_raw) == FRAMEDECODER_FRAME);
+	CHECK((decoder.type == FRAME_CAPTURE) && (decoder.width == 0));
+	CHECK(sendCmd == FRAME_NORMAL);
+}
+
+int main() {
+	testLepton2Stream();
+	testLepton3Stream();
+	testLostFrame();
+	testCorrupted();
+	testPartial();
+	testRegion();
+	testOtherFormats();
+	return hostResult("SerialFrameTest");
+}
@@ -0,0 +1,154 @@
+/*
+*
+* BENCHMARK - Measure the duration of the frame pipeline stages
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+/* Defines */
+
+//Number of frames to average the timings over
+#define benchmark_frames 20
+
+//Stages of the frame pipeline
+#define benchStage_capture  0
+#define benchStage_stats    1
+#define benchStage_box      2
+#define benchStage_gaussian 3
+#define benchStage_colors   4
+#define benchStage_edges    5
+#define benchStage_total    6
+
+/* Variables */
+
+//Names of the stages for the serial report
+const char* benchStageNames[benchStage_total] = { "getLeptonImage", "calcFrameStats",
+"boxFilter", "gaussianFilter", "convertColors", "fillEdges" };
+
+/* Methods */
+
+/* Print the average time of every stage and the frames per second */
+void benchmarkReport(uint32_t* stageTime, uint16_t frames) {
+	uint32_t total = 0;
+	Serial.println("*** Frame Pipeline Benchmark ***");
+	for (byte i = 0; i < benchStage_total; i++) {
+		Serial.print(benchStageNames[i]);
+		Serial.print(": ");
+		Serial.print(stageTime[i] / frames);
+		Serial.println(" us");
+		total += stageTime[i];
+	}
+	total /= frames;
+	Serial.print("Total: ");
+	Serial.print(total);
+	Serial.println(" us");
+	//Frames per second over the whole pipeline
+	Serial.print("Framerate: ");
+	if (total != 0)
+		Serial.print(1000000.0 / total, 2);
+	else
+		Serial.print(0);
+	Serial.println(" fps");
+	//VoSPI statistics since startup
+	Serial.print("Discard packets: ");
+	Serial.println(leptonDiscards);
+	Serial.print("Sync losses: ");
+	Serial.println(leptonSyncLosses);
+	Serial.print("Resets: ");
+	Serial.println(leptonResets);
+	Serial.print("CRC errors: ");
+	Serial.println(leptonCRCErrors);
+}
+
+/* Run the frame pipeline on a recorded .DAT frame or the live sensor */
+void benchmarkPipeline() {
+	char filename[20];
+	uint32_t stageTime[benchStage_total] = { 0 };
+	uint32_t measure;
+	bool fromFile = false;
+
+	//Wait for an optional .DAT filename, maximum 1 second
+	uint32_t timer = millis();
+	while (!Serial.available() && ((millis() - timer) < 1000));
+	if (Serial.available() > 0) {
+		String nameIn = Serial.readString();
+		nameIn.trim();
+		nameIn.toCharArray(filename, 20);
+		fromFile = (strlen(filename) != 0);
+	}
+
+	//The stages overwrite the limits and settings, save them
+	uint16_t old_minTemp = minTemp;
+	uint16_t old_maxTemp = maxTemp;
+	byte old_leptonVersion = leptonVersion;
+	byte old_calStatus = calStatus;
+	float old_calOffset = calOffset;
+	float old_calSlope = calSlope;
+
+	for (uint16_t frame = 0; frame < benchmark_frames; frame++) {
+		//Replay the recorded frame, not part of the timing
+		if (fromFile) {
+			loadRawData(filename);
+			selectColorScheme();
+		}
+		//Capture a frame from the Lepton
+		else {
+			measure = micros();
+			getLeptonImage();
+			stageTime[benchStage_capture] += micros() - measure;
+		}
+
+		//Frame statistics
+		measure = micros();
+		calcFrameStats();
+		stageTime[benchStage_stats] += micros() - measure;
+		//Find min and max, positions
+		limitValues();
+		findMinMaxPositions();
+
+		//Box filter
+		measure = micros();
+		boxFilter();
+		stageTime[benchStage_box] += micros() - measure;
+
+		//Gaussian filter
+		measure = micros();
+		gaussianFilter();
+		stageTime[benchStage_gaussian] += micros() - measure;
+
+		//Convert to RGB565
+		measure = micros();
+		convertColors();
+		stageTime[benchStage_colors] += micros() - measure;
+
+		//Fill the edges for visual / combined
+		measure = micros();
+		fillEdges();
+		stageTime[benchStage_edges] += micros() - measure;
+	}
+
+	//Send the results
+	benchmarkReport(stageTime, benchmark_frames);
+
+	//Restore the limits, the stages above have overwritten them
+	minTemp = old_minTemp;
+	maxTemp = old_maxTemp;
+	//Restore old settings from variables
+	if (fromFile) {
+		leptonVersion = old_leptonVersion;
+		calStatus = old_calStatus;
+		calOffset = old_calOffset;
+		calSlope = old_calSlope;
+		//Restore the rest from EEPROM
+		readEEPROM();
+		selectColorScheme();
+	}
+}
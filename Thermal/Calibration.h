@@ -52,21 +52,10 @@ uint16_t tempToRaw(float temp) {
 	return rawValue;
 }
 
-/* Calculates the average of the 196 (14x14) pixels in the middle */
+/* Returns the average of the 196 (14x14) pixels in the middle */
 uint16_t calcAverage() {
-	int sum = 0;
-	for (byte vert = 52; vert < 66; vert++) {
-		for (byte horiz = 72; horiz < 86; horiz++) {
-			uint16_t val = image[(vert * 160) + horiz];
-			//If one of the values contains hotter or colder values than the lepton can handle
-			if ((val == 16383) || (val == 0))
-				//Do not use that calibration set!
-				return 0;
-			sum += val;
-		}
-	}
-	uint16_t avg = (uint16_t)(sum / 196.0);
-	return avg;
+	//Calculated with the frame statistics, zero if not usable
+	return frameStats.average;
 }
 
 /* Compensate the calibration with object temp */
@@ -78,6 +67,9 @@ void compensateCalib() {
 	//Convert to Fahrenheit if needed
 	if (tempFormat == tempFormat_fahrenheit)
 		mlx90614Temp = celciusToFahrenheit(mlx90614Temp);
+	//Keep them with the frame statistics
+	frameStats.spot = mlx90614Temp;
+	frameStats.ambient = mlx90614Amb;
 
 	//Apply compensation if auto mode enabled, no limited locked and standard calib
 	if ((autoMode) && (!limitsLocked) && (calStatus != cal_warmup)) {
@@ -0,0 +1,268 @@
+/*
+*
+* CATALOG - Sorted index of the images and videos on the internal storage
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+/* Defines */
+
+#define catalog_fileName   "CATALOG.IDX"
+#define catalog_magic      "TCI1"
+#define catalog_headerSize 8
+#define catalog_entrySize  12
+//Entries moved at once when inserting or removing, fits into one sector
+#define catalog_moveCount  42
+
+//Types of the entries
+#define catalogType_raw    0
+#define catalogType_bitmap 1
+#define catalogType_video  2
+#define catalogType_qoi    3
+
+/* Variables */
+
+//One image or video, sorted by the packed time
+struct CatalogEntry {
+	uint32_t time;
+	byte type;
+	byte reserved;
+	uint16_t frames;
+	uint32_t size;
+};
+
+//Catalog file in the root folder
+SdFile catalogFile;
+//Number of entries in the catalog
+uint32_t catalogCount = 0;
+
+/* Methods */
+
+/* Checks if the year of a filename fits into the packed time, 2016 to 2079 */
+bool catalogValidTime(char* name) {
+	for (byte i = 0; i < 4; i++)
+		if (!isdigit(name[i]))
+			return false;
+	uint16_t year = ((name[0] - '0') * 1000) + ((name[1] - '0') * 100) + ((name[2] - '0') * 10) + (name[3] - '0');
+	return (year >= 2016) && (year < 2080);
+}
+
+/* Packs the time & date of a filename into 32 bits, sortable as a number */
+uint32_t catalogTime(char* name) {
+	uint32_t year = ((name[0] - '0') * 1000) + ((name[1] - '0') * 100) + ((name[2] - '0') * 10) + (name[3] - '0');
+	uint32_t month = ((name[4] - '0') * 10) + (name[5] - '0');
+	uint32_t day = ((name[6] - '0') * 10) + (name[7] - '0');
+	uint32_t hour = ((name[8] - '0') * 10) + (name[9] - '0');
+	uint32_t minute = ((name[10] - '0') * 10) + (name[11] - '0');
+	uint32_t second = ((name[12] - '0') * 10) + (name[13] - '0');
+	return (((year - 2016) & 0x3F) << 26) | (month << 22) | (day << 17) | (hour << 12) | (minute << 6) | second;
+}
+
+/* Creates the filename of an entry, including the ending for images */
+void catalogName(CatalogEntry* entry, char* name) {
+	uint32_t time = entry->time;
+	uint16_t year = 2016 + (time >> 26);
+	name[0] = '0' + year / 1000 % 10;
+	name[1] = '0' + year / 100 % 10;
+	name[2] = '0' + year / 10 % 10;
+	name[3] = '0' + year % 10;
+	byte parts[5] = { (byte)((time >> 22) & 0x0F), (byte)((time >> 17) & 0x1F),
+		(byte)((time >> 12) & 0x1F), (byte)((time >> 6) & 0x3F), (byte)(time & 0x3F) };
+	for (byte i = 0; i < 5; i++) {
+		name[4 + (i * 2)] = '0' + parts[i] / 10;
+		name[5 + (i * 2)] = '0' + parts[i] % 10;
+	}
+	name[14] = '\0';
+	if (entry->type == catalogType_raw)
+		strcpy(&name[14], ".DAT");
+	else if (entry->type == catalogType_bitmap)
+		strcpy(&name[14], ".BMP");
+	else if (entry->type == catalogType_qoi)
+		strcpy(&name[14], ".QOI");
+}
+
+/* Reads the entry at the position */
+bool catalogRead(uint32_t pos, CatalogEntry* entry) {
+	if (!catalogFile.seekSet(catalog_headerSize + ((uint32_t)pos * catalog_entrySize)))
+		return false;
+	return catalogFile.read(entry, catalog_entrySize) == catalog_entrySize;
+}
+
+/* Writes the entry at the position */
+void catalogWrite(uint32_t pos, CatalogEntry* entry) {
+	catalogFile.seekSet(catalog_headerSize + ((uint32_t)pos * catalog_entrySize));
+	catalogFile.write(entry, catalog_entrySize);
+}
+
+/* Writes the header with the number of entries */
+void catalogWriteHeader() {
+	catalogFile.seekSet(0);
+	catalogFile.write(catalog_magic, 4);
+	catalogFile.write(&catalogCount, 4);
+}
+
+/* Opens the catalog in the root folder, if not already open */
+bool catalogOpen() {
+	char magic[4];
+	if (catalogFile.isOpen())
+		return true;
+	//Independent from the current working directory
+	SdFile root;
+	root.openRoot(sd.vol());
+	if (!catalogFile.open(&root, catalog_fileName, O_RDWR))
+		return false;
+	//Check the header
+	if ((catalogFile.read(magic, 4) != 4) || (strncmp(magic, catalog_magic, 4) != 0)
+		|| (catalogFile.read(&catalogCount, 4) != 4)) {
+		catalogFile.close();
+		return false;
+	}
+	return true;
+}
+
+/* Creates an empty catalog, replaces the old one */
+bool catalogCreate() {
+	if (catalogFile.isOpen())
+		catalogFile.close();
+	SdFile root;
+	root.openRoot(sd.vol());
+	if (!catalogFile.open(&root, catalog_fileName, O_RDWR | O_CREAT | O_TRUNC))
+		return false;
+	catalogCount = 0;
+	catalogWriteHeader();
+	return true;
+}
+
+/* Closes the catalog */
+void catalogClose() {
+	if (catalogFile.isOpen())
+		catalogFile.close();
+}
+
+/* Moves the entries behind the position one entry back or forward, in blocks */
+void catalogShift(uint32_t pos, bool back) {
+	byte buffer[catalog_moveCount * catalog_entrySize];
+	uint32_t left = catalogCount - pos;
+	while (left > 0) {
+		uint32_t count = min(left, (uint32_t)catalog_moveCount);
+		//Back starts at the end, so nothing is overwritten before it was read
+		uint32_t from = back ? (pos + left - count) : (catalogCount - left);
+		uint32_t to = back ? (from + 1) : (from - 1);
+		catalogFile.seekSet(catalog_headerSize + (from * catalog_entrySize));
+		catalogFile.read(buffer, count * catalog_entrySize);
+		catalogFile.seekSet(catalog_headerSize + (to * catalog_entrySize));
+		catalogFile.write(buffer, count * catalog_entrySize);
+		left -= count;
+	}
+}
+
+/* Position of the first entry that is not older than the time */
+uint32_t catalogSearch(uint32_t time) {
+	CatalogEntry entry;
+	uint32_t low = 0;
+	uint32_t high = catalogCount;
+	while (low < high) {
+		uint32_t mid = (low + high) / 2;
+		catalogRead(mid, &entry);
+		if (entry.time < time)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+/* Inserts an entry at its sorted position */
+void catalogInsert(CatalogEntry* entry) {
+	CatalogEntry old;
+	uint32_t pos = catalogSearch(entry->time);
+	//Same name already there, the raw data has priority over the converted image
+	if ((pos < catalogCount) && catalogRead(pos, &old) && (old.time == entry->time)) {
+		if ((entry->type == catalogType_raw) || (old.type != catalogType_raw))
+			catalogWrite(pos, entry);
+		return;
+	}
+	//Move the newer entries back, new captures are usually appended
+	catalogShift(pos, true);
+	catalogWrite(pos, entry);
+	catalogCount++;
+	catalogWriteHeader();
+}
+
+/* Removes the entry at the position */
+void catalogRemoveAt(uint32_t pos) {
+	catalogShift(pos + 1, false);
+	catalogCount--;
+	catalogWriteHeader();
+	catalogFile.truncate(catalog_headerSize + ((uint32_t)catalogCount * catalog_entrySize));
+}
+
+/* Adds an image or video to the catalog, SD has to be started */
+void catalogAdd(char* name, byte type, uint32_t size, uint16_t frames) {
+	bool opened = catalogFile.isOpen();
+	//No catalog yet, it is built with all files on the next load
+	if (!catalogOpen())
+		return;
+	//Dates before 2016 do not fit into the packed time, they are not listed
+	if (catalogValidTime(name)) {
+		CatalogEntry entry;
+		entry.time = catalogTime(name);
+		entry.type = type;
+		entry.reserved = 0;
+		entry.frames = frames;
+		entry.size = size;
+		catalogInsert(&entry);
+	}
+	catalogFile.sync();
+	if (!opened)
+		catalogClose();
+}
+
+/* Removes an image or video from the catalog, SD has to be started */
+void catalogRemove(char* name) {
+	CatalogEntry entry;
+	bool opened = catalogFile.isOpen();
+	if (!catalogOpen())
+		return;
+	if (catalogValidTime(name)) {
+		uint32_t time = catalogTime(name);
+		uint32_t pos = catalogSearch(time);
+		if ((pos < catalogCount) && catalogRead(pos, &entry) && (entry.time == time))
+			catalogRemoveAt(pos);
+	}
+	catalogFile.sync();
+	if (!opened)
+		catalogClose();
+}
+
+/* Removes the catalog before the files can be changed from outside, the next load builds it again */
+void catalogInvalidate() {
+	startAltClockline(true);
+	catalogClose();
+	sd.remove(catalog_fileName);
+	endAltClockline();
+}
+
+/* Number of frames and size of a video folder */
+uint16_t catalogVideoFrames(SdFile* dir, uint32_t* size) {
+	SdFile video;
+	byte header[16];
+	uint16_t frames = 0;
+	*size = 0;
+	//Only the container knows the number of frames
+	if (video.open(dir, video_fileName, O_READ)) {
+		if ((video.read(header, 16) == 16) && (strncmp((char*)header, video_magic, 4) == 0))
+			frames = (header[14] << 8) | header[15];
+		*size = video.fileSize();
+		video.close();
+	}
+	return frames;
+}
@@ -13,360 +13,237 @@
 *
 */
 
+/* Variables */
+
+//Function to store one Lepton package, selected once per frame
+bool (*savePackage)(byte line, byte segment);
+
 /* Methods*/
 
-/* Filter the image with a box blur filter (LP) */
-void boxFilter() {
-	int sum;
+/* Store one Lepton2 package in the native 80x60 layout */
+bool savePackageLepton2(byte line, byte segment) {
+	uint32_t* dst = (uint32_t*)&image[line * 80];
+	byte* src = &leptonFrame[4];
+	uint16_t first, second;
+	for (byte column = 0; column < 80; column += 2) {
+		first = (src[0] << 8) | src[1];
+		second = (src[2] << 8) | src[3];
+		src += 4;
+		if ((first == 0) || (second == 0))
+			return false;
+		//Two pixels with one store
+		*dst++ = first | (second << 16);
+	}
+	return true;
+}
 
-	for (int y = 1; y < 119; y++) {
-		for (int x = 1; x < 159; x++) {
-			sum = 0;
-			for (int k = -1; k <= 1; k++) {
-				for (int j = -1; j <= 1; j++) {
-					sum += image[(y - j) * 160 + (x - k)];
-				}
-			}
-			image[(y * 160) + x] = (unsigned short)(sum / 9.0);
-		}
+/* Store one Lepton2 package turned by 180 degrees in the native 80x60 layout */
+bool savePackageLepton2Turned(byte line, byte segment) {
+	uint32_t* dst = (uint32_t*)&image[4798 - (line * 80)];
+	byte* src = &leptonFrame[4];
+	uint16_t first, second;
+	for (byte column = 0; column < 80; column += 2) {
+		first = (src[0] << 8) | src[1];
+		second = (src[2] << 8) | src[3];
+		src += 4;
+		if ((first == 0) || (second == 0))
+			return false;
+		//Two pixels with one store, in reverse order
+		*dst-- = second | (first << 16);
 	}
+	return true;
 }
 
-/* Filter the image with a gaussian blur filter (LP) */
-void gaussianFilter() {
-	byte gaussianKernel[3][3] = {
-		{ 1, 2, 1 },
-		{ 2, 4, 2 },
-		{ 1, 2, 1 }
-	};
-	int sum;
-
-	for (int y = 1; y < 119; y++) {
-		for (int x = 1; x < 159; x++) {
-			sum = 0;
-			for (int k = -1; k <= 1; k++) {
-				for (int j = -1; j <= 1; j++) {
-					sum += gaussianKernel[j + 1][k + 1] * image[(y - j) * 160 + (x - k)];
-				}
-			}
-			image[(y * 160) + x] = (unsigned short)(sum / 16.0);
-		}
+/* Store one Lepton3 package, segments from the bottom */
+bool savePackageLepton3(byte line, byte segment) {
+	uint16_t* dst = &image[19199 - ((segment - 1) * 4800) - ((line >> 1) * 160) - ((line & 1) * 80)];
+	byte* src = &leptonFrame[4];
+	uint16_t result;
+	for (byte column = 0; column < 80; column++) {
+		result = (src[0] << 8) | src[1];
+		src += 2;
+		if (result == 0)
+			return false;
+		*dst-- = result;
 	}
+	return true;
 }
 
-/* Store one package of 80 columns into RAM */
-bool savePackage(byte line, byte segment = 0) {
-	//Go through the video pixels for one video line
-	for (int column = 0; column < 80; column++) {
-		uint16_t result = (uint16_t)(leptonFrame[2 * column + 4] << 8
-			| leptonFrame[2 * column + 5]);
-		if (result == 0) {
+/* Store one Lepton3 package rotated, segments from the top */
+bool savePackageLepton3Rotated(byte line, byte segment) {
+	uint16_t* dst = &image[((segment - 1) * 4800) + ((line >> 1) * 160) + ((line & 1) * 80)];
+	byte* src = &leptonFrame[4];
+	uint16_t result;
+	for (byte column = 0; column < 80; column++) {
+		result = (src[0] << 8) | src[1];
+		src += 2;
+		if (result == 0)
 			return false;
-		}
-		//Lepton2
-		if (leptonVersion != leptonVersion_3_Shutter) {
-			if (((mlx90614Version == mlx90614Version_old) && (rotationEnabled == false)) ||
-				((mlx90614Version == mlx90614Version_new) && (rotationEnabled == true))) {
-				image[(line * 2 * 160) + (column * 2)] = result;
-				image[(line * 2 * 160) + (column * 2) + 1] = result;
-				image[(line * 2 * 160) + 160 + (column * 2)] = result;
-				image[(line * 2 * 160) + 160 + (column * 2) + 1] = result;
-			}
-			else {
-				image[19199 - ((line * 2 * 160) + (column * 2))] = result;
-				image[19199 - ((line * 2 * 160) + (column * 2) + 1)] = result;
-				image[19199 - ((line * 2 * 160) + 160 + (column * 2))] = result;
-				image[19199 - ((line * 2 * 160) + 160 + (column * 2) + 1)] = result;
-			}
-		}
-		//Lepton3
-		else {
-			//Fill array non rotated
-			if (!rotationEnabled) {
-				switch (segment) {
-				case 1:
-					image[19199 - (((line / 2) * 160) + ((line % 2) * 80) + (column))] = result;
-					break;
-				case 2:
-					image[14399 - (((line / 2) * 160) + ((line % 2) * 80) + (column))] = result;
-					break;
-				case 3:
-					image[9599 - (((line / 2) * 160) + ((line % 2) * 80) + (column))] = result;
-					break;
-				case 4:
-					image[4799 - (((line / 2) * 160) + ((line % 2) * 80) + (column))] = result;
-					break;
-				}
-			}
-			//Fill array rotated
-			else {
-				switch (segment) {
-				case 1:
-					image[((line / 2) * 160) + ((line % 2) * 80) + (column)] = result;
-					break;
-				case 2:
-					image[4800 + (((line / 2) * 160) + ((line % 2) * 80) + (column))] = result;
-					break;
-				case 3:
-					image[9600 + (((line / 2) * 160) + ((line % 2) * 80) + (column))] = result;
-					break;
-				case 4:
-					image[14400 + (((line / 2) * 160) + ((line % 2) * 80) + (column))] = result;
-					break;
-				}
-			}
-		}
+		*dst++ = result;
 	}
 	return true;
 }
 
+/* Select how to store the packages for the current sensor and orientation */
+void selectSavePackage() {
+	//Lepton2
+	if (leptonVersion != leptonVersion_3_Shutter) {
+		if (((mlx90614Version == mlx90614Version_old) && (rotationEnabled == false)) ||
+			((mlx90614Version == mlx90614Version_new) && (rotationEnabled == true)))
+			savePackage = savePackageLepton2;
+		else
+			savePackage = savePackageLepton2Turned;
+	}
+	//Lepton3
+	else {
+		if (!rotationEnabled)
+			savePackage = savePackageLepton3;
+		else
+			savePackage = savePackageLepton3Rotated;
+	}
+}
+
 /* Refresh the temperature points*/
 void refreshTempPoints() {
 	for (int y = 0; y < 12; y++) {
 		for (int x = 0; x < 16; x++) {
 			if (showTemp[(x + (16 * y))] != 0) {
-				showTemp[(x + (16 * y))] = image[(x * 10) + (y * 10 * 160) + 805];
+				//Native Lepton2 image
+				if (imageNative)
+					showTemp[(x + (16 * y))] = image[(x * 5) + (((y * 5) + 2) * 80) + 2];
+				else
+					showTemp[(x + (16 * y))] = image[(x * 10) + (y * 10 * 160) + 805];
 			}
 		}
 	}
 }
 
-/* Get one image from the Lepton module */
-void getTemperatures() {
-	byte leptonError, segmentNumbers, line;
-	//For Lepton2 sensor, get only one segment per frame
-	if (leptonVersion != leptonVersion_3_Shutter)
-		segmentNumbers = 1;
-	//For Lepton3 sensor, get four packages per frame
-	else
-		segmentNumbers = 4;
-	//Begin SPI transmission
-	leptonBeginSPI();
-	for (byte segment = 1; segment <= segmentNumbers; segment++) {
-		leptonError = 0;
-		do {
-			for (line = 0; line < 60; line++) {
-				//If line matches expectation
-				if (leptonReadFrame(line, segment)) {
-					if (!savePackage(line, segment)) {
-						//Stabilize framerate
-						delayMicroseconds(800);
-						//Raise lepton error
-						leptonError++;
-						break;
-					}
-				}
-				//Reset if the expected line does not match the answer
-				else {
-					if (leptonError == 255) {
-						//If show menu was entered
-						if (showMenu) {
-							leptonEndSPI();
-							return;
-						}
-						//Reset segment
-						segment = 1;
-						//Reset lepton error
-						leptonError = 0;
-						//End Lepton SPI
-						leptonEndSPI();
-						//Short delay
-						delay(186);
-						//Begin Lepton SPI
-						leptonBeginSPI();
-						break;
-					}
-					else {
-						//Stabilize framerate
-						delayMicroseconds(800);
-						//Raise lepton error
-						leptonError++;
-						break;
-					}
-				}
-			}
-		} while (line != 60);
+/* Move the first 20 lines of a Lepton3 segment to the position of another segment */
+void moveSegmentLines(byte from, byte to) {
+	uint16_t fromPos, toPos;
+	//Rotated, segments are stored from the top
+	if (rotationEnabled) {
+		fromPos = (from - 1) * 4800;
+		toPos = (to - 1) * 4800;
 	}
-	//End Lepton SPI
-	leptonEndSPI();
-}
-
-
-/* Find the position of the minimum and maximum value */
-void findMinMaxPositions()
-{
-	uint16_t min = 65535;
-	uint16_t max = 0;
-	//Go through the image
-	for (int i = 0; i < 19200; i++)
-	{
-		if (image[i] < min)
-		{
-			minTempPos = i;
-			min = image[i];
-		}
-		if (image[i] > max)
-		{
-			maxTempPos = i;
-			max = image[i];
-		}
-	}
-}
-
-/* Go through the array of temperatures and find min and max temp */
-void limitValues() {
-	maxTemp = 0;
-	minTemp = 65535;
-	uint16_t temp;
-	for (int i = 0; i < 19200; i++) {
-		//Get value
-		temp = image[i];
-		//Find maximum temp
-		if (temp > maxTemp)
-			maxTemp = temp;
-		//Find minimum temp
-		if (temp < minTemp)
-			minTemp = temp;
-	}
-}
-
-/* Get the colors for hot / cold mode selection */
-void getHotColdColors(byte* red, byte* green, byte* blue) {
-	switch (hotColdColor) {
-		//White
-	case hotColdColor_white:
-		*red = 255;
-		*green = 255;
-		*blue = 255;
-		break;
-		//Black
-	case hotColdColor_black:
-		*red = 0;
-		*green = 0;
-		*blue = 0;
-		break;
-		//White
-	case hotColdColor_red:
-		*red = 255;
-		*green = 0;
-		*blue = 0;
-		break;
-		//White
-	case hotColdColor_green:
-		*red = 0;
-		*green = 255;
-		*blue = 0;
-		break;
-		//White
-	case hotColdColor_blue:
-		*red = 0;
-		*green = 0;
-		*blue = 255;
-		break;
-	}
-}
-
-/* Convert the lepton values to RGB colors */
-void convertColors() {
-	uint8_t red, green, blue;
-
-	//Calculate the scale
-	float scale = (colorElements - 1.0) / (maxTemp - minTemp);
-
-	//For hot and cold mode, calculate rawlevel
-	float hotColdRawLevel = 0.0;
-	if ((hotColdMode != hotColdMode_disabled) && (displayMode != displayMode_combined))
-		hotColdRawLevel = tempToRaw(hotColdLevel);
-
-	for (int i = 0; i < 19200; i++) {
-		uint16_t value = image[i];
-
-		//Limit values
-		if (image[i] > maxTemp)
-			image[i] = maxTemp;
-		if (image[i] < minTemp)
-			image[i] = minTemp;
-
-		//Hot
-		if ((hotColdMode == hotColdMode_hot) && (value >= hotColdRawLevel) && (calStatus != cal_warmup) && (displayMode != displayMode_combined))
-			getHotColdColors(&red, &green, &blue);
-		//Cold
-		else if ((hotColdMode == hotColdMode_cold) && (value <= hotColdRawLevel) && (calStatus != cal_warmup) && (displayMode != displayMode_combined))
-			getHotColdColors(&red, &green, &blue);
-		//Apply colorscheme
-		else {
-			value = (image[i] - minTemp) * scale;
-			red = colorMap[3 * value];
-			green = colorMap[3 * value + 1];
-			blue = colorMap[3 * value + 2];
-		}
-		//Convert to RGB565
-		image[i] = (((red & 248) | green >> 5) << 8) | ((green & 28) << 3 | blue >> 3);
+	//Non rotated, segments are stored from the bottom
+	else {
+		fromPos = 17600 - ((from - 1) * 4800);
+		toPos = 17600 - ((to - 1) * 4800);
 	}
+	memcpy(&image[toPos], &image[fromPos], 1600 * sizeof(uint16_t));
 }
 
-/* Calculates the fill pixel for visual/combined */
-void calcFillPixel(uint16_t x, uint16_t y) {
-	uint16_t pixel;
-	byte red, green, blue;
-
-	//Combined - set to darker thermal
-	if (displayMode == displayMode_combined) {
-		//Get the thermal image color
-		pixel = image[x + (y * 160)];
-		//And extract the RGB values out of it
-		byte redT = (pixel & 0xF800) >> 8;
-		byte greenT = (pixel & 0x7E0) >> 3;
-		byte blueT = (pixel & 0x1F) << 3;
-		//Mix both
-		red = (byte)redT * (1 - adjCombAlpha) + 127 * adjCombAlpha;
-		green = (byte)greenT * (1 - adjCombAlpha) + 127 * adjCombAlpha;
-		blue = (byte)blueT * (1 - adjCombAlpha) + 127 * adjCombAlpha;
+/* Read one image from the Lepton module */
+void getLeptonImage() {
+	byte line, segmentsAll, packetSegment;
+	byte segment = 1;
+	byte segmentsDone = 0;
+	byte expectedLine = 0;
+	//For Lepton2 sensor, get only one segment per frame in the native size
+	if (leptonVersion != leptonVersion_3_Shutter) {
+		segmentsAll = 0x01;
+		//The end of the buffer has been used, the delta reference of the serial frames is gone
+		if (!imageNative)
+			deltaValid = false;
+		imageNative = true;
 	}
-	//Visual - set to black
+	//For Lepton3 sensor, get four segments per frame
 	else {
-		red = 0;
-		green = 0;
-		blue = 0;
+		segmentsAll = 0x0F;
+		imageNative = false;
 	}
-
-	//Set image to that calculated RGB565 value
-	pixel = (((red & 248) | green >> 5) << 8)
-		| ((green & 28) << 3 | blue >> 3);
-	//Save
-	image[x + (y * 160)] = pixel;
-}
-
-/* Fill out the edges in combined or visual mode */
-void fillEdges() {
-	//Fill the edges
-	uint16_t  x, y;
-
-	//Top & Bottom edges
-	for (x = 0; x < 160; x++) {
-		//Top edge
-		for (y = 0; y < (5 * adjCombDown); y++) {
-			calcFillPixel(x, y);
+	//Select how to store the packages
+	selectSavePackage();
+	//Begin SPI transmission
+	leptonBeginSPI();
+	uint32_t timer = millis();
+	while (segmentsDone != segmentsAll) {
+		//If show menu was entered
+		if (showMenu) {
+			leptonEndSPI();
+			return;
 		}
-
-		//Bottom edge
-		for (y = 119; y > (119 - (5 * adjCombUp)); y--) {
-			calcFillPixel(x, y);
+		//Reset the VoSPI if no valid line has been received for some time
+		if ((millis() - timer) > lepton_syncTimeout) {
+			leptonResets++;
+			expectedLine = 0;
+			leptonEndSPI();
+			delay(lepton_resetDelay);
+			leptonBeginSPI();
+			timer = millis();
 		}
-	}
-
-	//Left & right edges
-	for (y = 5 * adjCombDown; y < (120 - (5 * adjCombUp)); y++) {
-		//Left edge
-		for (x = 0; x < (5 * adjCombRight); x++) {
-			calcFillPixel(x, y);
+		//Receive the next packet
+		leptonReadPacket();
+		//Skip discard packets right after the header
+		if ((leptonFrame[0] & 0x0F) == 0x0F) {
+			leptonDiscards++;
+			continue;
 		}
-
-		//Right edge
-		for (x = 159; x > (159 - (5 * adjCombLeft)); x--) {
-			calcFillPixel(x, y);
+		//Corrupt packet, the segment has to be received again
+		if (!leptonCheckCRC()) {
+			leptonCRCErrors++;
+			expectedLine = 0;
+			continue;
+		}
+		line = leptonFrame[1];
+		//Line does not match the expectation, wait for the next segment
+		if (line != expectedLine) {
+			if (expectedLine != 0)
+				leptonSyncLosses++;
+			expectedLine = 0;
+			if (line != 0)
+				continue;
+		}
+		//Start of a segment, store it at the first missing one
+		if (line == 0) {
+			segment = 1;
+			while (segmentsDone & (1 << (segment - 1)))
+				segment++;
+		}
+		//For the Lepton3, the segment number is transmitted in line 20
+		if ((line == 20) && (leptonVersion == leptonVersion_3_Shutter)) {
+			packetSegment = leptonFrame[0] >> 4;
+			//Invalid segment, wait for the next one
+			if ((packetSegment == 0) || (packetSegment > 4)) {
+				expectedLine = 0;
+				continue;
+			}
+			//Segment received again, skip it so the stored one stays in one piece
+			if (segmentsDone & (1 << (packetSegment - 1))) {
+				expectedLine = 0;
+				continue;
+			}
+			//Segment arrived in another order, move the lines received so far
+			if (packetSegment != segment) {
+				moveSegmentLines(segment, packetSegment);
+				segment = packetSegment;
+			}
+		}
+		//Store the line, start over if it contains invalid values
+		if (!savePackage(line, segment)) {
+			leptonSyncLosses++;
+			expectedLine = 0;
+			continue;
+		}
+		timer = millis();
+		expectedLine++;
+		//Segment complete
+		if (expectedLine == 60) {
+			segmentsDone |= 1 << (segment - 1);
+			expectedLine = 0;
 		}
 	}
+	//End Lepton SPI
+	leptonEndSPI();
+}
+
+/* Get one image from the Lepton module and calculate its statistics */
+void getTemperatures() {
+	//Receive the temperatures over SPI
+	getLeptonImage();
+	//Calculate the statistics once per frame
+	calcFrameStats();
 }
 
 /* Create the visual or combined image display */
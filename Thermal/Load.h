@@ -20,17 +20,14 @@
 #define lepton3_small 38421
 #define lepton3_big 38805
 #define bitmap 614466
-#define maxFiles 500
+#define qoiImage 307222
 
-/* Variables */
+//Size of one SD sector
+#define sdSector_size 512
+//Read-ahead buffer, video frames stream into it with one multi-block read each
+#define readAhead_size 2048
 
-//Storage for up to maxFiles images/videos
-uint16_t* yearStorage;
-byte* monthStorage;
-byte* dayStorage;
-byte* hourStorage;
-byte* minuteStorage;
-byte* secondStorage;
+/* Variables */
 
 //Buffer for the single elements
 char yearBuf[] = "2016";
@@ -51,18 +48,24 @@ byte secondnum = 0;
 //Keep track how many images are on the SDCard
 int imgCount = 0;
 
+//Read-ahead buffer for the opened file
+byte readBuffer[readAhead_size];
+//Read position and number of valid bytes in the buffer
+uint16_t readBufferPos = 0;
+uint16_t readBufferLen = 0;
+//File position of the first byte in the buffer
+uint32_t readBufferStart = 0;
+//First block of the opened video container on the card, zero if it is not contiguous
+uint32_t readFirstBlock = 0;
+//Sectors of the frame come directly from the card with a multi-block read
+bool readStreamActive = false;
+//Position of the next streamed sector in the container
+uint32_t readStreamPos;
+
 /* Methods */
 
 /* Clear all previous data */
 void clearData() {
-	for (int i = 0; i < maxFiles; i++) {
-		yearStorage[i] = 0;
-		monthStorage[i] = 0;
-		dayStorage[i] = 0;
-		hourStorage[i] = 0;
-		minuteStorage[i] = 0;
-		secondStorage[i] = 0;
-	}
 	strcpy(yearBuf, "2016");
 	strcpy(monthBuf, "12");
 	strcpy(dayBuf, "31");
@@ -75,7 +78,6 @@ void clearData() {
 	hournum = 0;
 	minutenum = 0;
 	secondnum = 0;
-	imgCount = 0;
 	clearTemperatures();
 }
 
@@ -96,31 +98,164 @@ void displayRawData() {
 	display.writeScreen(image);
 }
 
+/* Discards the read-ahead buffer, required after opening a file */
+void readBufferReset() {
+	readBufferPos = 0;
+	readBufferLen = 0;
+	readFirstBlock = 0;
+}
+
+/* Starts a multi-block read at a sector of the contiguous container */
+bool readStreamStart(uint32_t pos) {
+	readBufferPos = 0;
+	readBufferLen = 0;
+	readStreamPos = pos;
+	readStreamActive = sd.card()->readStart(readFirstBlock + (pos / sdSector_size));
+	return readStreamActive;
+}
+
+/* Ends the multi-block read */
+void readStreamStop() {
+	if (!readStreamActive)
+		return;
+	readStreamActive = false;
+	sd.card()->readStop();
+}
+
+/* Fills the read-ahead buffer from the current file position */
+bool readBufferFill() {
+	//Next sectors of the multi-block read
+	if (readStreamActive) {
+		uint32_t fileSize = sdFile.fileSize();
+		readBufferStart = readStreamPos;
+		readBufferPos = 0;
+		readBufferLen = 0;
+		while ((readBufferLen < readAhead_size) && (readStreamPos < fileSize)) {
+			//Card error, continue through the file system
+			if (!sd.card()->readData(&readBuffer[readBufferLen])) {
+				readStreamStop();
+				readFirstBlock = 0;
+				sdFile.seekSet(readStreamPos);
+				break;
+			}
+			readBufferLen += sdSector_size;
+			readStreamPos += sdSector_size;
+		}
+		//The last sector may end behind the file
+		if ((readBufferStart + readBufferLen) > fileSize)
+			readBufferLen = fileSize - readBufferStart;
+		if ((readBufferLen != 0) || (readStreamActive))
+			return (readBufferLen != 0);
+	}
+	readBufferStart = sdFile.curPosition();
+	int count = sdFile.read(readBuffer, readAhead_size);
+	readBufferPos = 0;
+	readBufferLen = (count > 0) ? count : 0;
+	return (readBufferLen != 0);
+}
+
+/* Moves the read position, stays inside the buffer when possible */
+void readSeek(uint32_t pos) {
+	//Position is already in the buffer
+	if ((readBufferLen != 0) && (pos >= readBufferStart) && (pos < (readBufferStart + readBufferLen))) {
+		readBufferPos = pos - readBufferStart;
+		return;
+	}
+	//Start the transfer at the sector boundary
+	sdFile.seekSet(pos & ~511UL);
+	readBufferFill();
+	readBufferPos = pos & 511;
+	if (readBufferPos > readBufferLen)
+		readBufferPos = readBufferLen;
+}
+
+/* Reads one byte of the opened file, also used by the codecs */
+uint8_t rawReadByte() {
+	if ((readBufferPos == readBufferLen) && (!readBufferFill()))
+		return 0;
+	return readBuffer[readBufferPos++];
+}
+
+/* Returns the next byte of the opened file without consuming it */
+uint8_t rawPeekByte() {
+	if ((readBufferPos == readBufferLen) && (!readBufferFill()))
+		return 0;
+	return readBuffer[readBufferPos];
+}
+
+/* Reads a 16 bit value from the opened file, MSB first */
+uint16_t rawReadWord() {
+	uint16_t value = rawReadByte() << 8;
+	return value | rawReadByte();
+}
+
+/* Reads a 32 bit value from the opened file, MSB first */
+uint32_t rawReadLong() {
+	uint32_t value = (uint32_t)rawReadWord() << 16;
+	return value | rawReadWord();
+}
+
+/* Reads a number of 16 bit values from the opened file in blocks */
+void rawReadWords(uint16_t* dest, uint32_t count, bool msbFirst) {
+	while (count > 0) {
+		uint16_t left = readBufferLen - readBufferPos;
+		//Value split between two buffer fills
+		if (left == 1) {
+			byte first = rawReadByte();
+			byte second = rawReadByte();
+			*dest++ = msbFirst ? ((first << 8) | second) : ((second << 8) | first);
+			count--;
+			continue;
+		}
+		//Buffer empty, stop at the end of the file
+		if ((left == 0) && (!readBufferFill()))
+			return;
+		//Decode all complete values inside the buffer
+		uint32_t num = (readBufferLen - readBufferPos) / 2;
+		if (num > count)
+			num = count;
+		byte* src = &readBuffer[readBufferPos];
+		readBufferPos += num * 2;
+		count -= num;
+		if (msbFirst) {
+			for (; num > 0; num--, src += 2)
+				*dest++ = (src[0] << 8) | src[1];
+		}
+		else {
+			for (; num > 0; num--, src += 2)
+				*dest++ = (src[1] << 8) | src[0];
+		}
+	}
+}
+
 /* Loads a 640x480 BMP image from the SDCard and prints it on screen */
 void loadBMPImage(char* filename) {
-	//Help variables
-	byte low, high;
+	//One line of the bitmap
+	uint16_t line[640];
 	//Switch Clock to Alternative
 	startAltClockline();
 	// Open the file for reading
 	sdFile.open(filename, O_READ);
+	readBufferReset();
 
 	//Skip the 66 bytes BMP header
-	for (int i = 0; i < 66; i++)
-		sdFile.read();
+	readSeek(66);
+	//The image buffer gets the screen colors
+	imageNative = false;
 	//Repeat the procedure 4 times to fill all the buffers
 	for (int i = 3; i >= 0; i--) {
-		//Save those 20 lines to the SD card. Ascending to mirror vertically
-		for (int y = 119; y >= 0; y--) {
-			for (int x = 0; x < 640; x++) {
-				low = sdFile.read();
-				high = sdFile.read();
-				//Get the image color
-				image[(x / 2) + ((y / 2) * 320)] = (high << 8) | low;
-			}
+		//Every second line and pixel of the bitmap. Ascending to mirror vertically
+		for (int y = 59; y >= 0; y--) {
+			rawReadWords(line, 640, false);
+			rawReadWords(line, 640, false);
+			uint16_t* dest = &image[y * 320];
+			for (int x = 0; x < 320; x++)
+				dest[x] = line[(x * 2) + 1];
 		}
 		//Draw on the screen
+		endAltClockline();
 		display.drawBitmap(0, i * 60, 320, 60, image);
+		startAltClockline();
 	}
 
 	//Close data file
@@ -129,94 +264,129 @@ void loadBMPImage(char* filename) {
 	endAltClockline();
 }
 
-/* Loads raw data from the internal storage*/
-void loadRawData(char* filename, char* dirname) {
-	byte msb, lsb;
-	uint16_t result;
+/* Loads a 320x240 QOI image from the SDCard and prints it on screen */
+void loadQOIImage(char* filename) {
+	uint32_t width, height;
 	//Switch Clock to Alternative
 	startAltClockline();
-	//Go into the video folder if video
-	if (dirname != NULL)
-		sd.chdir(dirname);
 	// Open the file for reading
 	sdFile.open(filename, O_READ);
+	readBufferReset();
+
+	//The image buffer gets the screen colors
+	imageNative = false;
+	//Decode 320*60 pixels at one time
+	if ((qoiCodec.beginDecode(&width, &height, rawReadByte)) && (width == 320) && (height == 240)) {
+		for (byte i = 0; i < 4; i++) {
+			qoiCodec.decode(image, 19200);
+			//Draw on the screen
+			endAltClockline();
+			display.drawBitmap(0, i * 60, 320, 60, image);
+			startAltClockline();
+		}
+	}
 
-	//For the Lepton2 sensor, read 4800 raw values
-	if ((sdFile.fileSize() == lepton2_small) || (sdFile.fileSize() == lepton2_big)) {
-		for (int line = 0; line < 60; line++) {
-			for (int column = 0; column < 80; column++) {
-				msb = sdFile.read();
-				lsb = sdFile.read();
-				result = (((msb) << 8) + lsb);
-				image[(line * 2 * 160) + (column * 2)] = result;
-				image[(line * 2 * 160) + (column * 2) + 1] = result;
-				image[(line * 2 * 160) + 160 + (column * 2)] = result;
-				image[(line * 2 * 160) + 160 + (column * 2) + 1] = result;
-			}
+	//Close data file
+	sdFile.close();
+	//Switch clock back
+	endAltClockline();
+}
+
+/* Reads one raw frame from the read position of the opened file */
+void readRawData(bool lepton3, bool points) {
+	//Compressed frame, the flags tell the sensor and the points
+	if (rawPeekByte() == RAWCODEC_MARKER) {
+		rawReadByte();
+		byte flags = rawReadByte();
+		lepton3 = flags & RAWCODEC_LEPTON3;
+		points = flags & RAWCODEC_POINTS;
+		if (!lepton3) {
+			rawCodec.decode(image, 80, 60, rawReadByte);
+			leptonVersion = leptonVersion_2_Shutter;
+			imageNative = true;
 		}
+		else {
+			rawCodec.decode(image, 160, 120, rawReadByte);
+			leptonVersion = leptonVersion_3_Shutter;
+			imageNative = false;
+		}
+	}
+	//For the Lepton2 sensor, read 4800 raw values in the native size
+	else if (!lepton3) {
+		rawReadWords(image, 4800, true);
 		leptonVersion = leptonVersion_2_Shutter;
+		imageNative = true;
 	}
 	//For the Lepton3 sensor, read 19200 raw values
-	else if ((sdFile.fileSize() == lepton3_small) || (sdFile.fileSize() == lepton3_big)) {
-		for (int i = 0; i < 19200; i++) {
-			msb = sdFile.read();
-			lsb = sdFile.read();
-			image[i] = (((msb) << 8) + lsb);
-		}
-		leptonVersion = leptonVersion_3_Shutter;
-	}
-	//Invalid data
 	else {
-		showFullMessage((char*) "Invalid image size !");
-		sdFile.close();
-		endAltClockline();
-		return;
+		rawReadWords(image, 19200, true);
+		leptonVersion = leptonVersion_3_Shutter;
+		imageNative = false;
 	}
 
 	//Read Min
-	msb = sdFile.read();
-	lsb = sdFile.read();
-	minTemp = (((msb) << 8) + lsb);
+	minTemp = rawReadWord();
 	//Read Max
-	msb = sdFile.read();
-	lsb = sdFile.read();
-	maxTemp = (((msb) << 8) + lsb);
+	maxTemp = rawReadWord();
 
 	//Read object temperature
 	uint8_t farray[4];
 	for (int i = 0; i < 4; i++)
-		farray[i] = sdFile.read();
+		farray[i] = rawReadByte();
 	mlx90614Temp = bytesToFloat(farray);
 
 	//Read color scheme
-	colorScheme = sdFile.read();
+	colorScheme = rawReadByte();
 	//Read temp format
-	tempFormat = sdFile.read();
+	tempFormat = rawReadByte();
 	//Read spot enabled
-	spotEnabled = sdFile.read();
+	spotEnabled = rawReadByte();
 	//Read colorbar enabled
-	colorbarEnabled = sdFile.read();
+	colorbarEnabled = rawReadByte();
 	//Read points enabled
-	pointsEnabled = sdFile.read();
+	pointsEnabled = rawReadByte();
 
 	//Read calibration offset
 	for (int i = 0; i < 4; i++)
-		farray[i] = sdFile.read();
+		farray[i] = rawReadByte();
 	calOffset = bytesToFloat(farray);
 	//Read calibration slope
 	for (int i = 0; i < 4; i++)
-		farray[i] = sdFile.read();
+		farray[i] = rawReadByte();
 	calSlope = bytesToFloat(farray);
 
 	//Read temperature points
 	clearTemperatures();
-	if ((sdFile.fileSize() == lepton3_big) || (sdFile.fileSize() == lepton2_big)) {
-		for (int i = 0; i < 192; i++) {
-			//Read Min
-			msb = sdFile.read();
-			lsb = sdFile.read();
-			showTemp[i] = (((msb) << 8) + lsb);
-		}
+	if (points)
+		rawReadWords(showTemp, 192, true);
+}
+
+/* Loads raw data from the internal storage*/
+void loadRawData(char* filename, char* dirname) {
+	//Switch Clock to Alternative
+	startAltClockline();
+	//Go into the video folder if video
+	if (dirname != NULL)
+		sd.chdir(dirname);
+	// Open the file for reading
+	sdFile.open(filename, O_READ);
+	readBufferReset();
+
+	//Compressed frame, raw frames never start with the marker
+	if ((sdFile.fileSize() < lepton3_big) && (sdFile.peek() == RAWCODEC_MARKER))
+		readRawData(true, true);
+	//Lepton2 sensor
+	else if ((sdFile.fileSize() == lepton2_small) || (sdFile.fileSize() == lepton2_big))
+		readRawData(false, sdFile.fileSize() == lepton2_big);
+	//Lepton3 sensor
+	else if ((sdFile.fileSize() == lepton3_small) || (sdFile.fileSize() == lepton3_big))
+		readRawData(true, sdFile.fileSize() == lepton3_big);
+	//Invalid data
+	else {
+		showFullMessage((char*) "Invalid image size !");
+		sdFile.close();
+		endAltClockline();
+		return;
 	}
 
 	//Close data file
@@ -225,33 +395,86 @@ void loadRawData(char* filename, char* dirname) {
 	endAltClockline();
 }
 
-/* A method to choose the right yearStorage */
-bool yearChoose(char* filename) {
-	//Can imgCount up to 50 years
-	bool years[50] = { 0 };
-	//Go through all images
-	for (int i = 0; i < imgCount; i++) {
-		int yearCheck = yearStorage[i] - 2016;
-		//Check if the yearStorage is at least 2016
-		if (yearCheck < 0) {
-			//if it is not, return to main menu with error message
-			showFullMessage((char*) "The year must be >= 2016!");
-			delay(1000);
-			return true;
-			//Check if yearStorage is smaller than 2064 - unlikely the Thermocam is still in use then !
-		}
-		else if (yearCheck > 49) {
-			//if it is not, return to main menu with error message
-			showFullMessage((char*) "The year must be < 2064 !");
-			delay(1000);
-			return true;
-			//Add yearStorage to the array if passes the checks
-		}
-		else {
-			years[yearCheck] = true;
+/* Reads a 32 bit value from the opened file, MSB first */
+uint32_t readLong() {
+	uint32_t value = 0;
+	for (byte i = 0; i < 4; i++)
+		value = (value << 8) | sdFile.read();
+	return value;
+}
+
+/* Reads the header of the opened video container */
+bool readVideoHeader(uint32_t* frames, uint32_t* stride, bool* lepton3, uint16_t* interval) {
+	char magic[4];
+	sdFile.seekSet(0);
+	//Check if this is a video container
+	sdFile.read(magic, 4);
+	if (strncmp(magic, video_magic, 4) != 0)
+		return false;
+	//Lepton version
+	*lepton3 = (sdFile.read() == leptonVersion_3_Shutter);
+	//Skip the reserved byte and the number of raw values
+	sdFile.seekSet(8);
+	//Distance between two frames
+	*stride = readLong();
+	//Number of frames
+	*frames = readLong();
+	//Capture interval, skip the start time and the index position
+	if (interval != NULL) {
+		sdFile.seekSet(24);
+		*interval = (sdFile.read() << 8);
+		*interval |= sdFile.read();
+	}
+	//The frames are read through the read-ahead buffer
+	readBufferReset();
+	//Contiguous container, the frames can be streamed from the card
+	uint32_t lastBlock;
+	if (!sdFile.contiguousRange(&readFirstBlock, &lastBlock))
+		readFirstBlock = 0;
+	return true;
+}
+
+/* Reads one frame of the opened video container, returns its timestamp */
+uint32_t readVideoFrame(uint32_t frame, uint32_t stride, bool lepton3) {
+	uint32_t pos = video_headerSize + (frame * stride);
+	//All sectors of the frame with one multi-block read
+	if ((readFirstBlock == 0) || (!readStreamStart(pos)))
+		readSeek(pos);
+	uint32_t timestamp = rawReadLong();
+	readRawData(lepton3, true);
+	readStreamStop();
+	return timestamp;
+}
+
+/* Loads one frame of a video from the container or the single frame files */
+void loadVideoFrame(char* dirname, uint16_t frame) {
+	uint32_t frames, stride;
+	bool lepton3;
+	//Switch Clock to Alternative
+	startAltClockline();
+	//Go into the video folder
+	sd.chdir("/");
+	sd.chdir(dirname);
+	//Video container
+	if (sdFile.open(video_fileName, O_READ)) {
+		if ((readVideoHeader(&frames, &stride, &lepton3)) && (frame < frames)) {
+			//Jump directly to the frame
+			readVideoFrame(frame, stride, lepton3);
 		}
+		sdFile.close();
+		endAltClockline();
+		return;
 	}
-	for (int i = 0; i < 50; i++) {
+	endAltClockline();
+	//One file per frame, already inside the folder
+	char filename[] = "00000.DAT";
+	frameFilename(filename, frame);
+	loadRawData(filename);
+}
+
+/* A method to choose the right yearStorage */
+bool yearChoose(bool* years, char* filename) {
+	for (int i = 0; i < 64; i++) {
 		if (years[i])
 			yearnum = yearnum + 1;
 	}
@@ -259,7 +482,7 @@ bool yearChoose(char* filename) {
 	int Years[yearnum];
 	yearnum = 0;
 	//Add them in descending order
-	for (int i = 49; i >= 0; i--) {
+	for (int i = 63; i >= 0; i--) {
 		if (years[i]) {
 			Years[yearnum] = 2016 + i;
 			yearnum = yearnum + 1;
@@ -534,7 +757,9 @@ void copyIntoBuffers(char* filename) {
 bool checkFileValidity() {
 	return (sdFile.isDir()
 		|| (sdFile.isFile() && ((sdFile.fileSize() == lepton2_small) || (sdFile.fileSize() == lepton2_big) ||
-		(sdFile.fileSize() == lepton3_small) || (sdFile.fileSize() == lepton3_big) || (sdFile.fileSize() == bitmap))));
+		(sdFile.fileSize() == lepton3_small) || (sdFile.fileSize() == lepton3_big) || (sdFile.fileSize() == bitmap)))
+		|| (sdFile.isFile() && (sdFile.fileSize() < lepton3_big) && (sdFile.peek() == RAWCODEC_MARKER))
+		|| (sdFile.isFile() && (sdFile.fileSize() <= qoiImage) && (sdFile.peek() == 'q')));
 }
 
 /* Check if the name matches the criterion */
@@ -559,51 +784,49 @@ void checkFileStructure(bool* check) {
 	}
 }
 
-/* Check if the filename ends with .DAT or .BMP if the file is a single image */
+/* Check if the filename ends with .DAT, .BMP or .QOI if the file is a single image */
 void checkFileEnding(bool* check, char* filename) {
 	if (sdFile.isFile()) {
-		char ending_dat[] = ".DAT";
-		//Check for DAT first
-		if (((filename[14] != ending_dat[0]) || (filename[15] != ending_dat[1])
-			|| (filename[16] != ending_dat[2])
-			|| (filename[17] != ending_dat[3]))) {
-
-			//If it is not DAT, it could be BMP
-			char ending_bmp[] = ".BMP";
-			if ((filename[14] != ending_bmp[0]) || (filename[15] != ending_bmp[1])
-				|| (filename[16] != ending_bmp[2])
-				|| (filename[17] != ending_bmp[3]))
-				//None of both
-				*check = false;
-
-			//If bitmap, check if the file has a corresponding DAT
-			else {
-				strcpy(&filename[14], ".DAT");
-				sdFile.close();
-				//Check if it is a file
-				sdFile.open(filename, O_READ);
-				if (sdFile.isFile())
-					*check = false;
-				//Open the old file
-				strcpy(&filename[14], ".BMP");
-				sdFile.close();
-				sdFile.open(filename, O_READ);
-			}
+		//Raw data
+		if (strncmp(&filename[14], ".DAT", 4) == 0)
+			return;
+		//If it is not DAT, it could be BMP or QOI
+		if ((strncmp(&filename[14], ".BMP", 4) != 0) && (strncmp(&filename[14], ".QOI", 4) != 0)) {
+			//None of them
+			*check = false;
+			return;
 		}
+		//If converted image, check if the file has a corresponding DAT
+		char ending[5];
+		strncpy(ending, &filename[14], 5);
+		strcpy(&filename[14], ".DAT");
+		sdFile.close();
+		//Check if it is a file
+		sdFile.open(filename, O_READ);
+		if (sdFile.isFile())
+			*check = false;
+		//Open the old file
+		strcpy(&filename[14], ending);
+		sdFile.close();
+		sdFile.open(filename, O_READ);
 	}
 }
 
-/* Find the next or previous file/folder on the SD card or the position */
-bool findFile(char* filename, bool next, bool restart, int* position = 0, char* compare = NULL) {
-	bool found = false;
-	int counter = 0;
+/* Builds the catalog from the files on the SD card */
+void buildCatalog() {
+	char filename[20];
+	CatalogEntry entry;
 
 	//Start SD Transmission
-	startAltClockline(restart);
+	startAltClockline(true);
+	//New empty catalog
+	if (!catalogCreate()) {
+		endAltClockline();
+		return;
+	}
 
-	//Get filenames from SD Card - one after another and a maximum of maxFiles
+	//Get filenames from SD Card - one after another
 	while (sdFile.openNext(sd.vwd(), O_READ)) {
-
 		//Either folder for video or file with specific size for single image
 		if (checkFileValidity()) {
 			//Extract the filename into the buffers
@@ -614,93 +837,102 @@ bool findFile(char* filename, bool next, bool restart, int* position = 0, char*
 			checkFileStructure(&check);
 			//Check if the filename ends with .DAT or .BMP if the file is a single image
 			checkFileEnding(&check, filename);
-			//If all checks were successfull, add image to the results
+			//The year must be between 2016 and 2079
+			if (check)
+				check = catalogValidTime(filename);
+			//If all checks were successfull, add it to the catalog
 			if (check) {
-				//If we want to get the next image
-				if (next) {
-					found = true;
-					break;
+				entry.time = catalogTime(filename);
+				entry.reserved = 0;
+				if (sdFile.isDir()) {
+					entry.type = catalogType_video;
+					entry.frames = catalogVideoFrames(&sdFile, &entry.size);
 				}
-				//If we want to get the previous image or get the position
 				else {
-					if (compare != NULL) {
-						if (strcmp(compare, filename) == 0) {
-							*position = counter;
-							found = true;
-							break;
-						}
-						else
-							counter++;
-					}
-					//In case we found it
-					else if (*position == counter) {
-						found = true;
-						break;
-					}
-					//If not, raise the counter
+					if (filename[15] == 'D')
+						entry.type = catalogType_raw;
+					else if (filename[15] == 'B')
+						entry.type = catalogType_bitmap;
 					else
-						counter++;
+						entry.type = catalogType_qoi;
+					entry.frames = 0;
+					entry.size = sdFile.fileSize();
 				}
+				catalogInsert(&entry);
 			}
 		}
-
 		//Close the file
 		sdFile.close();
 	}
 
+	catalogFile.sync();
 	//End SD Transmission
 	endAltClockline();
-	//Return result
-	return found;
 }
 
-/* Search for files and videos */
-void searchFiles() {
-	char filename[20];
-	//Start SD Transmission
+/* Opens the catalog for the load menu, builds it if missing */
+void openCatalog() {
 	startAltClockline(true);
+	bool opened = catalogOpen();
+	endAltClockline();
+	//Missing or empty, mass storage mode removes it before the computer can change the files
+	if ((!opened) || (catalogCount == 0))
+		buildCatalog();
+	imgCount = catalogCount;
+}
 
-	//Get filenames from SD Card - one after another and a maximum of maxFiles
-	while (imgCount < maxFiles && sdFile.openNext(sd.vwd(), O_READ)) {
-		//Either folder for video or file with specific size for single image
-		if (checkFileValidity()) {
-			//Extract the filename into the buffers
-			copyIntoBuffers(filename);
-			//Check if the name matches the criterion
-			bool check = true;
-			//Check if the other elements are two digits each
-			checkFileStructure(&check);
-			//Check if the filename ends with .DAT or .BMP if the file is a single image
-			checkFileEnding(&check, filename);
-			//If all checks were successfull, add image to the results
-			if (check) {
-				//If the size of images is not too high
-				if (imgCount < maxFiles) {
-					yearStorage[imgCount] = atoi(yearBuf);
-					monthStorage[imgCount] = atoi(monthBuf);
-					dayStorage[imgCount] = atoi(dayBuf);
-					hourStorage[imgCount] = atoi(hourBuf);
-					minuteStorage[imgCount] = atoi(minuteBuf);
-					secondStorage[imgCount] = atoi(secondBuf);
-					//And raise imgCount by one
-					imgCount++;
-				}
-				//If there are maxFiles images or more
-				else {
-					endAltClockline();
-					//Display an error message
-					showFullMessage((char*) "Maximum number of files exceeded!");
-					delay(1000);
-					//And return to the main menu
-					mainMenu();
-					return;
-				}
-			}
-		}
-		//Close the file
-		sdFile.close();
-	}
+/* Get the name of the file/folder at the position of the catalog */
+bool findFile(char* filename, int pos) {
+	CatalogEntry entry;
+	bool found;
+	//Start SD Transmission
+	startAltClockline();
+	found = catalogRead(pos, &entry);
+	//End SD Transmission
+	endAltClockline();
+	if (found)
+		catalogName(&entry, filename);
+	return found;
+}
 
+/* Packed time of the elements chosen so far, down to the given bit */
+uint32_t choosePrefix(byte shift) {
+	uint32_t prefix = (uint32_t)(atoi(yearBuf) - 2016) << 26;
+	if (shift <= 22)
+		prefix |= (uint32_t)atoi(monthBuf) << 22;
+	if (shift <= 17)
+		prefix |= (uint32_t)atoi(dayBuf) << 17;
+	if (shift <= 12)
+		prefix |= (uint32_t)atoi(hourBuf) << 12;
+	if (shift <= 6)
+		prefix |= (uint32_t)atoi(minuteBuf) << 6;
+	return prefix;
+}
+
+/* Mark the values of one time element for all captures below the prefix */
+void chooseBuckets(bool* buckets, byte count, byte shift, byte mask, byte offset, uint32_t prefix, byte prefixShift) {
+	CatalogEntry entry;
+	uint32_t start = 0;
+	uint32_t end = catalogCount;
+
+	//Start SD Transmission
+	startAltClockline();
+	//The catalog is sorted, so the matching captures are in one block
+	if (prefixShift < 32) {
+		start = catalogSearch(prefix);
+		uint32_t next = prefix + (1UL << prefixShift);
+		if (next > prefix)
+			end = catalogSearch(next);
+	}
+	//Go through the block once
+	catalogFile.seekSet(catalog_headerSize + (start * catalog_entrySize));
+	for (uint32_t i = start; i < end; i++) {
+		if (catalogFile.read(&entry, catalog_entrySize) != catalog_entrySize)
+			break;
+		byte value = ((entry.time >> shift) & mask) - offset;
+		if (value < count)
+			buckets[value] = true;
+	}
 	//End SD Transmission
 	endAltClockline();
 }
@@ -709,34 +941,27 @@ void searchFiles() {
 void chooseFile(char* filename) {
 	//Look for Years
 YearLabel:
+	//We have up to 64 years
+	bool years[64] = { 0 };
+	chooseBuckets(years, 64, 26, 0x3F, 0, 0, 32);
 	//If the user wants to return to the main menu
 	if (yearnum == 1
-		|| yearChoose(filename)) {
+		|| yearChoose(years, filename)) {
 		return;
 	}
 	//Look for monthStorage
 MonthLabel:
-	//We have twelve months
+	//We have twelve months, substract one to start array by zero
 	bool months[12] = { 0 };
-	for (int i = 0; i < imgCount; i++) {
-		//Add monthStorage if it belongs to the chosen yearStorage
-		if (yearStorage[i] == atoi(yearBuf))
-			//Substract one to start array by zero
-			months[monthStorage[i] - 1] = true;
-	}
+	chooseBuckets(months, 12, 22, 0x0F, 1, choosePrefix(26), 26);
 	//If the user wants to go back to the years
 	if (monthChoose(months, filename))
 		goto YearLabel;
 	//Look for dayStorage
 DayLabel:
-	//We have 31 days
+	//We have 31 days, the dayStorage has to match the yearStorage and the monthStorage chosen
 	bool days[31] = { 0 };
-	for (int i = 0; i < imgCount; i++) {
-		//The dayStorage has to match the yearStorage and the monthStorage chosen
-		if ((yearStorage[i] == atoi(yearBuf)) && (monthStorage[i] == atoi(monthBuf)))
-			//Substract one to start array by zero
-			days[dayStorage[i] - 1] = true;
-	}
+	chooseBuckets(days, 31, 17, 0x1F, 1, choosePrefix(22), 22);
 	//If the user wants to go back to the months
 	if (dayChoose(days, filename)) {
 		if (monthnum > 1)
@@ -746,14 +971,9 @@ DayLabel:
 	}
 	//Look for hourStorage
 HourLabel:
-	//We have 24 hours
+	//We have 24 hours, look for match at years, monthStorage and dayStorage
 	bool hours[24] = { 0 };
-	for (int i = 0; i < imgCount; i++) {
-		//Look for match at years, monthStorage and dayStorage
-		if ((yearStorage[i] == atoi(yearBuf)) && (monthStorage[i] == atoi(monthBuf))
-			&& (dayStorage[i] == atoi(dayBuf)))
-			hours[hourStorage[i]] = true;
-	}
+	chooseBuckets(hours, 24, 12, 0x1F, 0, choosePrefix(17), 17);
 	//If the user wants to go back to the days
 	if (hourChoose(hours, filename)) {
 		if (daynum > 1)
@@ -765,14 +985,9 @@ HourLabel:
 	}
 	//Look for minuteStorage
 MinuteLabel:
-	//We have 60 minutes
+	//We have 60 minutes, watch for yearStorage, monthStorage, dayStorage and hourStorage
 	bool minutes[60] = { 0 };
-	for (int i = 0; i < imgCount; i++) {
-		//Watch for yearStorage, monthStorage, dayStorage and hourStorage
-		if ((yearStorage[i] == atoi(yearBuf)) && (monthStorage[i] == atoi(monthBuf))
-			&& (dayStorage[i] == atoi(dayBuf)) && (hourStorage[i] == atoi(hourBuf)))
-			minutes[minuteStorage[i]] = true;
-	}
+	chooseBuckets(minutes, 60, 6, 0x3F, 0, choosePrefix(12), 12);
 	//If the user wants to go back to the hours
 	if (minuteChoose(minutes, filename)) {
 		if (hournum > 1)
@@ -785,15 +1000,9 @@ MinuteLabel:
 			goto YearLabel;
 	}
 	//Look for secondStorage
-	//We have 60 seconds
+	//We have 60 seconds, watch for all the elements before
 	bool seconds[60] = { 0 };
-	for (int i = 0; i < imgCount; i++) {
-		//Watch for yearStorage, monthStorage, dayStorage, hourStorage and minuteStorage
-		if ((yearStorage[i] == atoi(yearBuf)) && (monthStorage[i] == atoi(monthBuf))
-			&& (dayStorage[i] == atoi(dayBuf)) && (hourStorage[i] == atoi(hourBuf))
-			&& (minuteStorage[i] == atoi(minuteBuf)))
-			seconds[secondStorage[i]] = true;
-	}
+	chooseBuckets(seconds, 60, 0, 0x3F, 0, choosePrefix(6), 6);
 	//If the user wants to go back to the minutes
 	if (secondChoose(seconds, filename)) {
 		if (minutenum > 1)
@@ -818,6 +1027,14 @@ MinuteLabel:
 	//If not, use bitmap
 	strcpy(&filename[14], ".BMP");
 	sdFile.close();
+	sdFile.open(filename, O_READ);
+	if (sdFile.isFile()) {
+		sdFile.close();
+		return;
+	}
+	//Otherwise the QOI image
+	strcpy(&filename[14], ".QOI");
+	sdFile.close();
 }
 
 /* Delete image / video function */
@@ -828,10 +1045,8 @@ bool loadDelete(char* filename, int* pos) {
 	//Video
 	else
 		deleteVideo(filename);
-	//Clear all previous data
-	clearData();
-	//Search files
-	searchFiles();
+	//The delete has removed it from the catalog
+	imgCount = catalogCount;
 	//If there are no files left, return
 	if (imgCount == 0) {
 		showFullMessage((char*) "No images/videos found!");
@@ -842,7 +1057,7 @@ bool loadDelete(char* filename, int* pos) {
 	if (*pos > (imgCount - 1))
 		*pos = imgCount - 1;
 	//Find the name of the next file
-	findFile(filename, false, true, pos);
+	findFile(filename, *pos);
 	return true;
 }
 
@@ -856,25 +1071,13 @@ void loadFind(char* filename, int* pos) {
 	}
 	//Clear all previous data
 	clearData();
-	//Search files
-	searchFiles();
 	//Let the user choose a new file
 	chooseFile(filename);
 	isImage(filename);
-	char compare[20];
-	strncpy(compare, filename, 20);
 	//Find the new file position
-	findFile(filename, false, true, pos, compare);
-}
-
-/* Alloc space for the different arrays*/
-void loadAlloc() {
-	yearStorage = (uint16_t*)calloc(maxFiles, sizeof(uint16_t));
-	monthStorage = (byte*)calloc(maxFiles, sizeof(byte));
-	dayStorage = (byte*)calloc(maxFiles, sizeof(byte));
-	hourStorage = (byte*)calloc(maxFiles, sizeof(byte));
-	minuteStorage = (byte*)calloc(maxFiles, sizeof(byte));
-	secondStorage = (byte*)calloc(maxFiles, sizeof(byte));
+	startAltClockline();
+	*pos = catalogSearch(catalogTime(filename));
+	endAltClockline();
 }
 
 /* Change settings for load menu */
@@ -890,16 +1093,6 @@ void loadSettings() {
 	hotColdMode = hotColdMode_disabled;
 }
 
-/* De-Alloc space for the different arrays*/
-void loadDeAlloc() {
-	free(yearStorage);
-	free(monthStorage);
-	free(dayStorage);
-	free(hourStorage);
-	free(minuteStorage);
-	free(secondStorage);
-}
-
 /* Interrupt handler for the load touch menu */
 void loadTouchIRQ() {
 	//Get touch coordinates 
@@ -958,15 +1151,16 @@ void load() {
 	showFullMessage((char*) "Please wait..");
 	//Change settings
 	loadSettings();
-	//Alloc space
-	loadAlloc();
 	//Clear all previous data
 	clearData();
-	//Search files
-	searchFiles();
+	//Open the catalog
+	openCatalog();
 
 	//If there are no images or videos, return
 	if (imgCount == 0) {
+		startAltClockline();
+		catalogClose();
+		endAltClockline();
 		showFullMessage((char*) "No images/videos found!");
 		delay(1000);
 		return;
@@ -974,7 +1168,7 @@ void load() {
 
 	//Open the latest file
 	int pos = imgCount - 1;
-	findFile(filename, false, true, &pos);
+	findFile(filename, pos);
 	bool exit = false;
 
 	//New touch interrupt
@@ -1010,12 +1204,11 @@ void load() {
 			//Previous
 		case loadTouch_previous:
 			showFullMessage((char*) "Loading..");
-			if (!findFile(filename, true, false)) {
-				findFile(filename, true, true);
+			if (pos == (imgCount - 1))
 				pos = 0;
-			}
 			else
 				pos++;
+			findFile(filename, pos);
 			break;
 
 			//Next
@@ -1025,7 +1218,7 @@ void load() {
 				pos = imgCount - 1;
 			else
 				pos--;
-			findFile(filename, false, true, &pos);
+			findFile(filename, pos);
 			break;
 
 			//Exit
@@ -1055,12 +1248,14 @@ void load() {
 			break;
 	}
 
+	//Close the catalog
+	startAltClockline();
+	catalogClose();
+	endAltClockline();
+
 	//Display message
 	showFullMessage((char*)"Returning to live mode..");
 
-	//Deallocate space
-	loadDeAlloc();
-
 	//Restore old settings from variables
 	minTemp = old_minTemp;
 	maxTemp = old_maxTemp;
@@ -0,0 +1,454 @@
+/*
+*
+* PIPELINE - Processing stages of the thermal frame, without hardware access
+*
+* DIY-Thermocam Firmware
+*
+* GNU General Public License v3.0
+*
+* Copyright by Max Ritter
+*
+* http://www.diy-thermocam.net
+* https://github.com/maxritter/DIY-Thermocam
+*
+*/
+
+/* Defines */
+
+//Reciprocal of 9 as 11.21 fixed point, exact for all 3x3 sums of 14 bit values
+#define filter_boxRecip 233017
+#define filter_boxShift 21
+
+/* Variables */
+
+//Rolling buffer for the horizontal sums of three lines
+uint16_t filterLines[3][160];
+
+//Factor from raw value offset to color index, 32.32 fixed point
+uint64_t colorLUTScale;
+//Settings the lookup table has been built for
+const byte* colorLUTMap = NULL;
+uint16_t colorLUTMin;
+uint16_t colorLUTMax;
+uint16_t colorLUTLevel;
+byte colorLUTHotCold;
+byte colorLUTColor;
+//Table entry of the hot / cold color, behind the color scheme
+byte colorLUTHotColdIndex;
+//Raw values of the hot / cold color, a pixel matches if (value ^ flip) >= start
+uint16_t colorLUTFlip;
+uint32_t colorLUTStart;
+
+/* Methods */
+
+/* Calculate the horizontal kernel sums of one line */
+void filterLine(uint16_t* src, uint16_t* dst, bool gaussian, byte width) {
+	uint16_t left = src[0];
+	uint16_t center = src[1];
+	uint16_t right;
+	//Gaussian kernel 1-2-1
+	if (gaussian) {
+		for (byte x = 1; x < (width - 1); x++) {
+			right = src[x + 1];
+			dst[x] = left + (center << 1) + right;
+			left = center;
+			center = right;
+		}
+	}
+	//Box kernel 1-1-1
+	else {
+		for (byte x = 1; x < (width - 1); x++) {
+			right = src[x + 1];
+			dst[x] = left + center + right;
+			left = center;
+			center = right;
+		}
+	}
+}
+
+/* Filter the image with a separable 3x3 kernel, the border stays untouched */
+void separableFilter(bool gaussian) {
+	uint16_t* above = filterLines[0];
+	uint16_t* center = filterLines[1];
+	uint16_t* below = filterLines[2];
+	uint16_t* temp;
+	uint16_t* dst;
+	//Native Lepton2 image or full resolution
+	byte width = imageNative ? 80 : 160;
+	byte height = imageNative ? 60 : 120;
+
+	//Horizontal sums of the first two lines
+	filterLine(&image[0], above, gaussian, width);
+	filterLine(&image[width], center, gaussian, width);
+
+	for (byte y = 1; y < (height - 1); y++) {
+		//Sum up the next line before the current one gets overwritten
+		filterLine(&image[(y + 1) * width], below, gaussian, width);
+		dst = &image[y * width];
+		//Vertical pass, divide by 16
+		if (gaussian) {
+			for (byte x = 1; x < (width - 1); x++)
+				dst[x] = (above[x] + (center[x] << 1) + below[x]) >> 4;
+		}
+		//Vertical pass, divide by 9 with the fixed point reciprocal
+		else {
+			for (byte x = 1; x < (width - 1); x++)
+				dst[x] = ((uint64_t)(above[x] + center[x] + below[x]) * filter_boxRecip) >> filter_boxShift;
+		}
+		//Rotate the line buffer
+		temp = above;
+		above = center;
+		center = below;
+		below = temp;
+	}
+}
+
+/* Filter the image with a box blur filter (LP) */
+void boxFilter() {
+	separableFilter(false);
+}
+
+/* Filter the image with a gaussian blur filter (LP) */
+void gaussianFilter() {
+	separableFilter(true);
+}
+
+/* Calculate min, max, their positions, the center average and the histogram */
+void calcFrameStats() {
+	uint32_t* pair = (uint32_t*)image;
+	uint32_t val;
+	uint16_t low, high;
+	uint16_t min = 65535;
+	uint16_t max = 0;
+	uint16_t minPos = 0;
+	uint16_t maxPos = 0;
+	//Native Lepton2 image or full resolution
+	uint16_t size = imageNative ? 4800 : 19200;
+
+	//Time of the capture
+	frameStats.time = millis();
+	//Clear the histogram
+	memset(frameStats.histogram, 0, sizeof(frameStats.histogram));
+
+	//Go through the image with one word load per pixel pair
+	for (uint16_t i = 0; i < size; i += 2) {
+		val = *pair++;
+		low = val & 0xFFFF;
+		high = val >> 16;
+		//First pixel of the pair
+		if (low < min) {
+			min = low;
+			minPos = i;
+		}
+		if (low > max) {
+			max = low;
+			maxPos = i;
+		}
+		//Second pixel of the pair
+		if (high < min) {
+			min = high;
+			minPos = i + 1;
+		}
+		if (high > max) {
+			max = high;
+			maxPos = i + 1;
+		}
+		//Histogram with 64 bins over the 14 bit range
+		frameStats.histogram[(low & 0x3FFF) >> 8]++;
+		frameStats.histogram[(high & 0x3FFF) >> 8]++;
+	}
+
+	//Positions are given for the full resolution
+	if (imageNative) {
+		minPos = ((minPos / 80) * 320) + ((minPos % 80) * 2);
+		maxPos = ((maxPos / 80) * 320) + ((maxPos % 80) * 2);
+	}
+
+	//Store the results
+	frameStats.min = min;
+	frameStats.max = max;
+	frameStats.minPos = minPos;
+	frameStats.maxPos = maxPos;
+
+	//Average of the 196 (14x14) pixels in the middle, 49 (7x7) for the native image
+	byte roiSize = imageNative ? 7 : 14;
+	byte width = imageNative ? 80 : 160;
+	uint16_t* roi = &image[(imageNative ? ((26 * 80) + 36) : ((52 * 160) + 72))];
+	uint32_t sum = 0;
+	frameStats.average = 0;
+	for (byte vert = 0; vert < roiSize; vert++) {
+		for (byte horiz = 0; horiz < roiSize; horiz++) {
+			low = roi[horiz];
+			//If one of the values contains hotter or colder values than the lepton can handle
+			if ((low == 16383) || (low == 0))
+				//Do not use that calibration set!
+				return;
+			sum += low;
+		}
+		roi += width;
+	}
+	frameStats.average = sum / (roiSize * roiSize);
+}
+
+/* Take the position of the minimum and maximum value from the statistics */
+void findMinMaxPositions()
+{
+	minTempPos = frameStats.minPos;
+	maxTempPos = frameStats.maxPos;
+}
+
+/* Take min and max temp from the statistics */
+void limitValues() {
+	minTemp = frameStats.min;
+	maxTemp = frameStats.max;
+}
+
+/* Get the colors for hot / cold mode selection */
+void getHotColdColors(byte* red, byte* green, byte* blue) {
+	switch (hotColdColor) {
+		//White
+	case hotColdColor_white:
+		*red = 255;
+		*green = 255;
+		*blue = 255;
+		break;
+		//Black
+	case hotColdColor_black:
+		*red = 0;
+		*green = 0;
+		*blue = 0;
+		break;
+		//White
+	case hotColdColor_red:
+		*red = 255;
+		*green = 0;
+		*blue = 0;
+		break;
+		//White
+	case hotColdColor_green:
+		*red = 0;
+		*green = 255;
+		*blue = 0;
+		break;
+		//White
+	case hotColdColor_blue:
+		*red = 0;
+		*green = 0;
+		*blue = 255;
+		break;
+	}
+}
+
+/* Convert a color to RGB565 */
+uint16_t colorToRGB565(byte red, byte green, byte blue) {
+	return (((red & 248) | green >> 5) << 8) | ((green & 28) << 3 | blue >> 3);
+}
+
+/* Build the RGB565 lookup table for the current limits and color scheme */
+void buildColorLUT(byte hotCold, uint16_t rawLevel) {
+	byte red, green, blue;
+	uint16_t element;
+
+	//A full color scheme leaves one entry for the hot / cold color
+	int16_t schemeCount = colorElements;
+	if ((hotCold != hotColdMode_disabled) && (schemeCount == 256))
+		schemeCount = 255;
+
+	//Scale from raw value offset to color index, exact after the shift
+	if (maxTemp > minTemp)
+		colorLUTScale = (((uint64_t)(schemeCount - 1)) << 32) / (maxTemp - minTemp) + 1;
+	else
+		colorLUTScale = 0;
+
+	//Apply colorscheme, skip one color in the middle if shortened
+	for (int16_t i = 0; i < schemeCount; i++) {
+		element = (i * (colorElements - 1)) / (schemeCount - 1);
+		colorLUT[i] = colorToRGB565(colorMap[3 * element], colorMap[3 * element + 1], colorMap[3 * element + 2]);
+	}
+	colorLUTCount = schemeCount;
+
+	//The hot / cold pixels are found with the exact raw value, not the color index
+	colorLUTFlip = 0;
+	colorLUTStart = 0x10000;
+	if (hotCold != hotColdMode_disabled) {
+		getHotColdColors(&red, &green, &blue);
+		colorLUTHotColdIndex = colorLUTCount;
+		colorLUT[colorLUTCount++] = colorToRGB565(red, green, blue);
+		//Hot, value >= level
+		if (hotCold == hotColdMode_hot)
+			colorLUTStart = rawLevel;
+		//Cold, value <= level is the same as ~value >= ~level
+		else {
+			colorLUTFlip = 0xFFFF;
+			colorLUTStart = rawLevel ^ 0xFFFF;
+		}
+	}
+
+	//Remember the settings
+	colorLUTMap = colorMap;
+	colorLUTMin = minTemp;
+	colorLUTMax = maxTemp;
+	colorLUTLevel = rawLevel;
+	colorLUTHotCold = hotCold;
+	colorLUTColor = hotColdColor;
+}
+
+/* Upscale the native Lepton2 image to 160x120 */
+void upscaleImage() {
+	uint16_t* src = &image[4799];
+	uint32_t* dst;
+	uint32_t pixel;
+	//Go backwards, so every pixel is read before it gets overwritten
+	for (int8_t y = 59; y >= 0; y--) {
+		dst = (uint32_t*)&image[(y * 320) + 158];
+		for (byte x = 0; x < 80; x++) {
+			pixel = *src--;
+			//Two pixels with one store, then the row below
+			pixel |= pixel << 16;
+			dst[80] = pixel;
+			*dst-- = pixel;
+		}
+	}
+	imageNative = false;
+}
+
+/* Rebuild the lookup table only if the limits or settings have changed */
+void updateColorLUT() {
+	//For hot and cold mode, calculate rawlevel
+	byte hotCold = hotColdMode_disabled;
+	uint16_t hotColdRawLevel = 0;
+	if ((hotColdMode != hotColdMode_disabled) && (calStatus != cal_warmup) && (displayMode != displayMode_combined)) {
+		hotCold = hotColdMode;
+		hotColdRawLevel = tempToRaw(hotColdLevel);
+	}
+
+	if ((colorMap != colorLUTMap) || (minTemp != colorLUTMin) || (maxTemp != colorLUTMax) ||
+		(hotCold != colorLUTHotCold) || (hotColdRawLevel != colorLUTLevel) || (hotColdColor != colorLUTColor))
+		buildColorLUT(hotCold, hotColdRawLevel);
+}
+
+/* Convert the lepton values to indices of the color lookup table, one byte each */
+void convertIndices() {
+	uint16_t value;
+	//The indices are stored in place, in front of the values not read yet
+	byte* indices = (byte*)image;
+
+	updateColorLUT();
+
+	//Native Lepton2 image or full resolution
+	uint16_t size = imageNative ? 4800 : 19200;
+	for (uint16_t i = 0; i < size; i++) {
+		value = image[i];
+
+		//Hot or cold pixel
+		if ((uint16_t)(value ^ colorLUTFlip) >= colorLUTStart) {
+			indices[i] = colorLUTHotColdIndex;
+			continue;
+		}
+
+		//Limit values
+		if (value > maxTemp)
+			value = maxTemp;
+		else if (value < minTemp)
+			value = minTemp;
+
+		//Get the index of the color
+		indices[i] = ((uint32_t)(value - minTemp) * colorLUTScale) >> 32;
+	}
+}
+
+/* Convert the lepton values to RGB colors */
+void convertColors() {
+	uint16_t value;
+
+	updateColorLUT();
+
+	//Native Lepton2 image or full resolution
+	uint16_t size = imageNative ? 4800 : 19200;
+	for (uint16_t i = 0; i < size; i++) {
+		value = image[i];
+
+		//Hot or cold pixel
+		if ((uint16_t)(value ^ colorLUTFlip) >= colorLUTStart) {
+			image[i] = colorLUT[colorLUTHotColdIndex];
+			continue;
+		}
+
+		//Limit values
+		if (value > maxTemp)
+			value = maxTemp;
+		else if (value < minTemp)
+			value = minTemp;
+
+		//Get the RGB565 color from the lookup table
+		image[i] = colorLUT[((uint32_t)(value - minTemp) * colorLUTScale) >> 32];
+	}
+
+	//Bring the native Lepton2 image to the display resolution
+	if (imageNative)
+		upscaleImage();
+}
+
+/* Calculates the fill pixel for visual/combined */
+void calcFillPixel(uint16_t x, uint16_t y) {
+	uint16_t pixel;
+	byte red, green, blue;
+
+	//Combined - set to darker thermal
+	if (displayMode == displayMode_combined) {
+		//Get the thermal image color
+		pixel = image[x + (y * 160)];
+		//And extract the RGB values out of it
+		byte redT = (pixel & 0xF800) >> 8;
+		byte greenT = (pixel & 0x7E0) >> 3;
+		byte blueT = (pixel & 0x1F) << 3;
+		//Mix both
+		red = (byte)redT * (1 - adjCombAlpha) + 127 * adjCombAlpha;
+		green = (byte)greenT * (1 - adjCombAlpha) + 127 * adjCombAlpha;
+		blue = (byte)blueT * (1 - adjCombAlpha) + 127 * adjCombAlpha;
+	}
+	//Visual - set to black
+	else {
+		red = 0;
+		green = 0;
+		blue = 0;
+	}
+
+	//Set image to that calculated RGB565 value
+	pixel = (((red & 248) | green >> 5) << 8)
+		| ((green & 28) << 3 | blue >> 3);
+	//Save
+	image[x + (y * 160)] = pixel;
+}
+
+/* Fill out the edges in combined or visual mode */
+void fillEdges() {
+	//Fill the edges
+	uint16_t  x, y;
+
+	//Top & Bottom edges
+	for (x = 0; x < 160; x++) {
+		//Top edge
+		for (y = 0; y < (5 * adjCombDown); y++) {
+			calcFillPixel(x, y);
+		}
+
+		//Bottom edge
+		for (y = 119; y > (119 - (5 * adjCombUp)); y--) {
+			calcFillPixel(x, y);
+		}
+	}
+
+	//Left & right edges
+	for (y = 5 * adjCombDown; y < (120 - (5 * adjCombUp)); y++) {
+		//Left edge
+		for (x = 0; x < (5 * adjCombRight); x++) {
+			calcFillPixel(x, y);
+		}
+
+		//Right edge
+		for (x = 159; x > (159 - (5 * adjCombLeft)); x--) {
+			calcFillPixel(x, y);
+		}
+	}
+}
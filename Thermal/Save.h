@@ -13,8 +13,101 @@
 *
 */
 
+/* Variables */
+
+//Sector buffer for the raw data writer
+byte rawBuffer[sdSector_size];
+//Position inside the sector buffer
+uint16_t rawBufferPos = 0;
+//Target file of the raw data writer
+SdFile* rawFile = &sdFile;
+//Bytes of the codec output and the limit, a frame that does not get smaller is stored raw
+uint32_t rawCodedCount;
+uint32_t rawCodedLimit;
+
+//Container for the raw video frames
+SdFile videoFile;
+//Distance between two frames in the container
+uint32_t videoStride;
+//Size allocated in one contiguous block
+uint32_t videoPrealloc;
+//Start of the recording
+uint32_t videoStartTime;
+uint32_t videoStartMillis;
+//First block of the container on the card, zero if it is not contiguous
+uint32_t videoFirstBlock = 0;
+//Sectors of the frame go directly to the card with a multi-block write
+bool videoStreamActive = false;
+//Position of the next streamed sector in the container
+uint32_t videoStreamPos;
+
 /* Methods*/
 
+/* Starts a multi-block write at a position of the contiguous container */
+bool videoStreamStart(uint32_t pos, uint32_t size) {
+	videoStreamPos = pos;
+	//The block count lets the card pre-erase the blocks
+	videoStreamActive = sd.card()->writeStart(videoFirstBlock + (pos / sdSector_size), size / sdSector_size);
+	return videoStreamActive;
+}
+
+/* Ends the multi-block write */
+void videoStreamStop() {
+	if (!videoStreamActive)
+		return;
+	videoStreamActive = false;
+	sd.card()->writeStop();
+}
+
+/* Writes the full sector buffer to the multi-block write or the file */
+void rawWriteSector() {
+	if (videoStreamActive) {
+		if (sd.card()->writeData(rawBuffer)) {
+			videoStreamPos += sdSector_size;
+			rawBufferPos = 0;
+			return;
+		}
+		//Card error, continue the recording through the file system
+		videoStreamStop();
+		videoFirstBlock = 0;
+		videoFile.seekSet(videoStreamPos);
+	}
+	rawFile->write(rawBuffer, sdSector_size);
+	rawBufferPos = 0;
+}
+
+/* Add one byte to the raw data, write the sector when it is full */
+inline void rawWriteByte(byte value) {
+	rawBuffer[rawBufferPos++] = value;
+	if (rawBufferPos == sdSector_size)
+		rawWriteSector();
+}
+
+/* Add one value to the raw data, MSB first */
+inline void rawWriteWord(uint16_t value) {
+	rawWriteByte(value >> 8);
+	rawWriteByte(value & 0xFF);
+}
+
+/* Add a 32 bit value to the raw data, MSB first */
+inline void rawWriteLong(uint32_t value) {
+	rawWriteWord(value >> 16);
+	rawWriteWord(value & 0xFFFF);
+}
+
+/* Add one byte of the codec output, nothing behind the limit */
+void rawWriteCoded(byte value) {
+	if (rawCodedCount++ < rawCodedLimit)
+		rawWriteByte(value);
+}
+
+/* Write the rest of the raw data */
+void rawWriteFlush() {
+	if (rawBufferPos != 0)
+		rawFile->write(rawBuffer, rawBufferPos);
+	rawBufferPos = 0;
+}
+
 /* Creates a filename from the current time & date */
 void createSDName(char* filename, bool folder) {
 	char buffer[5];
@@ -100,26 +193,6 @@ void checkImageSave() {
 	}
 }
 
-/* Creates a bmp file for the thermal image */
-void createBMPFile(char* filename) {
-	//File extension and open
-	strcpy(&filename[14], ".BMP");
-	sdFile.open(filename, O_RDWR | O_CREAT | O_AT_END);
-	//640 x 480 bitmap header
-	const char bmp_header[66] = { 0x42, 0x4D, 0x36, 0x60, 0x09, 0x00, 0x00,
-		0x00, 0x00, 0x00, 0x42, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
-		0x80, 0x02, 0x00, 0x00, 0xE0, 0x01, 0x00, 0x00, 0x01, 0x00, 0x10,
-		0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x60, 0x09, 0x00, 0xC4, 0x0E,
-		0x00, 0x00, 0xC4, 0x0E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-		0x00, 0x00, 0x00, 0x00, 0xF8, 0x00, 0x00, 0xE0, 0x07, 0x00, 0x00,
-		0x1F, 0x00, 0x00, 0x00 };
-	//Write the BMP header
-	for (int i = 0; i < 66; i++) {
-		char ch = bmp_header[i];
-		sdFile.write((uint8_t*)&ch, 1);
-	}
-}
-
 /* Creates a jpg file for the visual image */
 void createJPGFile(char* filename, char* dirname) {
 	//Begin SD Transmission
@@ -146,18 +219,11 @@ void createVideoFolder(char* dirname) {
 	endAltClockline();
 }
 
-/* Save video frame to image file */
-void saveVideoFrame(char* filename, char* dirname) {
-	//Begin SD Transmission
-	startAltClockline(true);
-
-	//Switch to video folder 
-	sd.chdir(dirname);
-	// Open the file for writing
-	sdFile.open(filename, O_RDWR | O_CREAT | O_AT_END);
-
+/* Save video frame as bitmap into the opened video folder, video frames stay BMP */
+void saveVideoFrame(SdFile* dir, char* filename) {
+	SdFile bmpFile;
 	//160 x 120 bitmap header
-	const char bmp_header[66] = { 0x42, 0x4D, 0x00, 0x00, 0x00, 0x00, 0x00,
+	static const uint8_t bmp_header[66] = { 0x42, 0x4D, 0x00, 0x00, 0x00, 0x00, 0x00,
 		0x00, 0x00, 0x00, 0x42, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00,
 		0x00, 0xA0, 0x00, 0x00, 0x00, 0x88, 0xFF, 0xFF, 0xFF, 0x01,
 		0x00, 0x10, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -165,59 +231,49 @@ void saveVideoFrame(char* filename, char* dirname) {
 		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x00,
 		0x00, 0xE0, 0x07, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 };
 
-	//Write the BMP header
-	for (int i = 0; i < 66; i++) {
-		char ch = bmp_header[i];
-		sdFile.write((uint8_t*)&ch, 1);
-	}
-
-	//Write all the data
-	sdFile.write((uint8_t*)image, 38400);
-
+	//Open the file for writing, replaces an incomplete one from an aborted conversion
+	bmpFile.open(dir, filename, O_RDWR | O_CREAT | O_TRUNC);
+	//Write the BMP header and all the data as blocks
+	bmpFile.write(bmp_header, 66);
+	bmpFile.write((uint8_t*)image, 38400);
 	//Close the file
-	sdFile.close();
-	//Switch Clock back to Standard
-	endAltClockline();
+	bmpFile.close();
+}
+
+/* Expands one line of the framebuffer to the 320 pixels of the screen */
+void framebufferLine(uint16_t* line, byte y) {
+	uint16_t* pixels = &image[y * 160];
+	for (uint16_t x = 0; x < 160; x++) {
+		line[x * 2] = pixels[x];
+		line[(x * 2) + 1] = pixels[x];
+	}
 }
 
 /* Saves a thermal or combined image to the sd card */
 void saveDisplayImage(char* filename, char* dirname) {
+	uint16_t line[320];
 	//Begin SD Transmission
 	startAltClockline(true);
 	//Switch to video folder if video
 	if (dirname != NULL)
 		sd.chdir(dirname);
-	//Create file
-	createBMPFile(filename);
-	//Allocate space for sd buffer
-	uint8_t* sdBuffer = (uint8_t*)calloc(640, sizeof(uint8_t));
-	unsigned short pixel;
-	//Save 320*60 pixels from the screen at one time
-	for (int i = 3; i >= 0; i--) {
-		endAltClockline();
-		//Read pixels from the display
-		display.readScreen(i, image);
-		startAltClockline();
-		for (byte y = 0; y < 60; y++) {
-			//Write them into the sd buffer
-			for (uint16_t x = 0; x < 320; x++) {
-				pixel = image[((59 - y) * 320) + x];
-				sdBuffer[x * 2] = pixel & 0x00FF;
-				sdBuffer[(x * 2) + 1] = (pixel & 0xFF00) >> 8;
-			}
-			//Write them to the sd card with 640x480 resolution
-			for (int i = 0; i < 2; i++) {
-				for (uint16_t x = 0; x < 320; x++) {
-					sdFile.write(sdBuffer[x * 2]);
-					sdFile.write(sdBuffer[(x * 2) + 1]);
-					sdFile.write(sdBuffer[x * 2]);
-					sdFile.write(sdBuffer[(x * 2) + 1]);
-				}
-			}
-		}
+	//File extension and open
+	strcpy(&filename[14], ".QOI");
+	sdFile.open(filename, O_RDWR | O_CREAT | O_TRUNC);
+	//Encode through the sector buffer
+	rawBufferPos = 0;
+	qoiCodec.beginEncode(320, 240, rawWriteByte);
+	//The framebuffer contains the image with all infos, every line twice
+	for (byte y = 0; y < 120; y++) {
+		framebufferLine(line, y);
+		qoiCodec.encode(line, 320);
+		qoiCodec.encode(line, 320);
 	}
-	//De-allocate space
-	free(sdBuffer);
+	qoiCodec.endEncode();
+	rawWriteFlush();
+	//Add single images to the catalog
+	if (dirname == NULL)
+		catalogAdd(filename, catalogType_qoi, sdFile.fileSize());
 	//Close file
 	sdFile.close();
 	//End SD Transmission
@@ -230,7 +286,7 @@ void saveImage() {
 	if ((visualEnabled == true) && (displayMode == displayMode_thermal))
 		captureVisualImage();
 
-	//Save Bitmap image if activated or in visual / combined mode
+	//Save QOI image if activated or in visual / combined mode
 	if ((convertEnabled == true) || (displayMode == displayMode_visual) || (displayMode == displayMode_combined))
 		saveDisplayImage(saveFilename);
 
@@ -259,9 +315,9 @@ void saveImage() {
 	else if (displayMode == displayMode_thermal)
 		showTransMessage((char*) "Thermal RAW saved!");
 	else if (displayMode == displayMode_visual)
-		showTransMessage((char*) "Visual BMP saved!");
+		showTransMessage((char*) "Visual QOI saved!");
 	else if (displayMode == displayMode_combined)
-		showTransMessage((char*) "Combined BMP saved!");
+		showTransMessage((char*) "Combined QOI saved!");
 
 	//Disable image save marker
 	imgSave = imgSave_disabled;
@@ -296,11 +352,34 @@ void frameFilename(char* filename, uint16_t count) {
 	filename[4] = '0' + count % 10;
 }
 
+/* Find the first frame to convert, the frame bitmaps are created in order */
+uint16_t convertStart(SdFile* dir, uint16_t framesCaptured) {
+	char filename[] = "00000.BMP";
+	uint16_t low = 0;
+	uint16_t high = framesCaptured;
+	//Binary search for the first frame without a .BMP
+	while (low < high) {
+		uint16_t mid = (low + high) / 2;
+		frameFilename(filename, mid);
+		if (dir->exists(filename))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	//The last frame may be incomplete after a power loss, convert it again
+	if (low > 0)
+		low--;
+	return low;
+}
+
 /* Proccess video frames */
 void proccessVideoFrames(uint16_t framesCaptured, char* dirname) {
 	char buffer[30];
-	char filename[] = "00000.DAT";
+	char filename[] = "00000.BMP";
 	uint16_t framesConverted = 0;
+	uint32_t frames, stride;
+	bool lepton3, container, noSpace = false;
+	SdFile videoDir;
 
 	//Display screen content
 	display.fillScr(200, 200, 200);
@@ -310,34 +389,61 @@ void proccessVideoFrames(uint16_t framesCaptured, char* dirname) {
 	display.print((char*)"Video conversion", CENTER, 30);
 	display.setFont(smallFont);
 	display.setColor(VGA_BLACK);
-	display.print((char*)"Converts all .DAT to .BMP frames", CENTER, 80);
+	display.print((char*)"Converts all raw frames to .BMP", CENTER, 80);
 	display.print((char*)"Press button to abort the process", CENTER, 120);
-	sprintf(buffer, "Frames converted: %5d / %5d", framesConverted, framesCaptured);
-	display.print(buffer, CENTER, 160);
 	sprintf(buffer, "Folder name: %s", dirname);
 	display.print(buffer, CENTER, 200);
 
+	//Free space, counted down instead of reading the whole FAT for every frame
+	uint32_t freeKB = getSDSpace();
+
+	startAltClockline(true);
+	//Open the folder once for all frames, the callers are already inside it
+	sd.chdir("/");
+	if (!videoDir.open(dirname, O_READ)) {
+		endAltClockline();
+		showFullMessage((char*) "Video folder not found!");
+		delay(1000);
+		return;
+	}
+	//Continue an aborted conversion
+	uint16_t framesStart = convertStart(&videoDir, framesCaptured);
+	//Keep the container open and read the frames one after another
+	container = sdFile.open(&videoDir, video_fileName, O_READ);
+	if ((container) && (!readVideoHeader(&frames, &stride, &lepton3))) {
+		sdFile.close();
+		container = false;
+	}
+	endAltClockline();
+
+	sprintf(buffer, "Frames converted: %5d / %5d", framesStart, framesCaptured);
+	display.print(buffer, CENTER, 160);
+
 	//Switch to processing mode
 	videoSave = videoSave_processing;
+	uint32_t startTime = millis();
 
 	//Go through all the frames in the folder
-	for (framesConverted = 0; framesConverted < framesCaptured; framesConverted++) {
+	for (framesConverted = framesStart; framesConverted < framesCaptured; framesConverted++) {
 		//Check if there is at least 1MB of space left
-		if (getSDSpace() < 1000) {
-			showFullMessage((char*) "No space, stop conversion..");
-			delay(1000);
-			return;
+		if (freeKB < 1000) {
+			noSpace = true;
+			break;
 		}
 
 		//Button pressed, exit
 		if (videoSave != videoSave_processing)
 			break;
 
-		//Get filename
-		frameFilename(filename, framesConverted);
-		strcpy(&filename[5], ".DAT");
-		//Load Raw data
-		loadRawData(filename, dirname);
+		//Load Raw data from the opened container
+		if (container) {
+			startAltClockline();
+			readVideoFrame(framesConverted, stride, lepton3);
+			endAltClockline();
+		}
+		//Or from the single frame file
+		else
+			loadVideoFrame(dirname, framesConverted);
 
 		//Apply low-pass filter
 		if (filterType == filterType_box)
@@ -352,15 +458,38 @@ void proccessVideoFrames(uint16_t framesCaptured, char* dirname) {
 		displayInfos();
 
 		//Save frame to image file
-		strcpy(&filename[5], ".BMP");
-		saveVideoFrame(filename, dirname);
+		startAltClockline();
+		frameFilename(filename, framesConverted);
+		saveVideoFrame(&videoDir, filename);
+		endAltClockline();
+		freeKB -= 38;
 
-		//Update screen content
+		//Update screen content with the speed
 		display.setBackColor(200, 200, 200);
 		display.setFont(smallFont);
 		display.setColor(VGA_BLACK);
 		sprintf(buffer, "Frames converted: %5d / %5d", framesConverted + 1, framesCaptured);
 		display.print(buffer, CENTER, 160);
+		uint32_t elapsed = millis() - startTime;
+		if (elapsed != 0) {
+			uint32_t fps = ((uint32_t)(framesConverted + 1 - framesStart) * 10000) / elapsed;
+			sprintf(buffer, "Speed: %3d.%d fps", (int)(fps / 10), (int)(fps % 10));
+			display.print(buffer, CENTER, 180);
+		}
+	}
+
+	//Close the container and the folder
+	startAltClockline();
+	if (container)
+		sdFile.close();
+	videoDir.close();
+	endAltClockline();
+
+	//Not enough space
+	if (noSpace) {
+		showFullMessage((char*) "No space, stop conversion..");
+		delay(1000);
+		return;
 	}
 
 	//All images converted!
@@ -368,9 +497,126 @@ void proccessVideoFrames(uint16_t framesCaptured, char* dirname) {
 	delay(1000);
 }
 
+/* Moves inside the video container, fills the gap behind the end of the file */
+void videoSeek(uint32_t pos) {
+	if (videoFile.fileSize() < pos) {
+		videoFile.seekEnd();
+		memset(rawBuffer, 0, sdSector_size);
+		while (videoFile.fileSize() < pos)
+			videoFile.write(rawBuffer, sdSector_size);
+	}
+	videoFile.seekSet(pos);
+}
+
+/* Writes the header sector of the video container */
+void writeVideoHeader(uint32_t frames, uint32_t indexOffset) {
+	rawFile = &videoFile;
+	videoFile.seekSet(0);
+	rawBufferPos = 0;
+	//Magic
+	for (byte i = 0; i < 4; i++)
+		rawWriteByte(video_magic[i]);
+	//Lepton version
+	rawWriteByte(leptonVersion);
+	rawWriteByte(0);
+	//Number of raw values per frame
+	if (leptonVersion != leptonVersion_3_Shutter)
+		rawWriteWord(4800);
+	else
+		rawWriteWord(19200);
+	//Distance between two frames
+	rawWriteLong(videoStride);
+	//Number of frames
+	rawWriteLong(frames);
+	//Start time of the recording
+	rawWriteLong(videoStartTime);
+	//Position of the timestamp index, zero while recording
+	rawWriteLong(indexOffset);
+	//Capture interval
+	rawWriteWord(videoInterval);
+	//Fill the sector, it is written when full
+	while (rawBufferPos != 0)
+		rawWriteByte(0);
+}
+
+/* Creates the container for the raw frames inside the video folder */
+void createVideoFile(char* dirname) {
+	uint32_t frames = 0;
+	//Every frame starts at a sector with its timestamp
+	uint32_t size = video_frameHeader;
+	if (leptonVersion != leptonVersion_3_Shutter)
+		size += lepton2_big;
+	else
+		size += lepton3_big;
+	videoStride = ((size + sdSector_size - 1) / sdSector_size) * sdSector_size;
+
+	//Allocate as many frames as possible, but keep 2MB free
+	uint32_t freeKB = getSDSpace();
+	if (freeKB > 2048)
+		frames = (freeKB - 2048) / (videoStride / 1024);
+	if (frames > video_preallocFrames)
+		frames = video_preallocFrames;
+	videoPrealloc = video_headerSize + (frames * videoStride);
+
+	//Remember the start
+	videoStartTime = now();
+	videoStartMillis = millis();
+
+	startAltClockline(true);
+	sd.chdir(dirname);
+	videoFirstBlock = 0;
+	//Try to create one contiguous block, otherwise a normal file
+	if ((frames == 0) || (!videoFile.createContiguous(sd.vwd(), video_fileName, videoPrealloc))) {
+		videoPrealloc = 0;
+		videoFile.open(video_fileName, O_RDWR | O_CREAT | O_TRUNC);
+	}
+	//Pre-erase the blocks, the frames are streamed there with multi-block writes
+	else {
+		uint32_t lastBlock;
+		if (videoFile.contiguousRange(&videoFirstBlock, &lastBlock))
+			sd.card()->erase(videoFirstBlock, lastBlock);
+	}
+	//Header without frames
+	writeVideoHeader(0, 0);
+	rawFile = &sdFile;
+	endAltClockline();
+}
+
+/* Adds the timestamp index and closes the video container */
+void closeVideoFile(char* dirname, uint16_t framesCaptured) {
+	uint32_t indexOffset = video_headerSize + ((uint32_t)framesCaptured * videoStride);
+	uint32_t indexPos = indexOffset;
+	uint16_t count = 0;
+
+	startAltClockline(true);
+	//Compressed frames may end before the index
+	videoSeek(indexOffset);
+	//Collect the timestamps of the frames, one sector at a time
+	for (uint16_t i = 0; i < framesCaptured; i++) {
+		videoFile.seekSet(video_headerSize + ((uint32_t)i * videoStride));
+		videoFile.read(&rawBuffer[count * video_frameHeader], video_frameHeader);
+		count++;
+		//Sector full or last frame, append it to the index
+		if ((count == (sdSector_size / video_frameHeader)) || (i == (framesCaptured - 1))) {
+			videoFile.seekSet(indexPos);
+			videoFile.write(rawBuffer, count * video_frameHeader);
+			indexPos += count * video_frameHeader;
+			count = 0;
+		}
+	}
+	//Release the unused preallocated space
+	videoFile.truncate(indexPos);
+	//Final header with the index
+	writeVideoHeader(framesCaptured, indexOffset);
+	//Add the video to the catalog
+	catalogAdd(dirname, catalogType_video, videoFile.fileSize(), framesCaptured);
+	videoFile.close();
+	rawFile = &sdFile;
+	endAltClockline();
+}
+
 /* Saves raw data for an image or an video frame */
 void saveRawData(bool isImage, char* name, uint16_t framesCaptured) {
-	uint16_t result;
 
 	//Start SD
 	startAltClockline(true);
@@ -379,85 +625,130 @@ void saveRawData(bool isImage, char* name, uint16_t framesCaptured) {
 		strcpy(&name[14], ".DAT");
 		sdFile.open(name, O_RDWR | O_CREAT | O_AT_END);
 	}
-	//Create filename for video frame
-	else {
-		char filename[] = "00000.DAT";
-		frameFilename(filename, framesCaptured);
-		sd.chdir(name);
-		sdFile.open(filename, O_RDWR | O_CREAT | O_AT_END);
-	}
-
-	//For the Lepton2 sensor, write 4800 raw values
-	if (leptonVersion != leptonVersion_3_Shutter) {
-		for (int line = 0; line < 60; line++) {
-			for (int column = 0; column < 80; column++) {
-				result = image[(line * 2 * 160) + (column * 2)];
-				sdFile.write((result & 0xFF00) >> 8);
-				sdFile.write(result & 0x00FF);
-			}
-		}
+
+	//Start with an empty sector
+	rawBufferPos = 0;
+	//Start of the frame, to write it again without compression
+	uint32_t framePos = isImage ? sdFile.curPosition() : video_headerSize + ((uint32_t)framesCaptured * videoStride);
+	uint32_t frameTime = millis() - videoStartMillis;
+
+	//Append video frame to the container
+	if (!isImage) {
+		rawFile = &videoFile;
+		//Inside the contiguous block, stream the frame directly to its sectors
+		if ((videoFirstBlock == 0) || ((framePos + videoStride) > videoPrealloc)
+			|| (!videoStreamStart(framePos, videoStride)))
+			videoSeek(framePos);
+		//Time since the start of the recording
+		rawWriteLong(frameTime);
 	}
 
-	//For the Lepton3 sensor, write 19200 raw values
-	else {
-		for (int i = 0; i < 19200; i++) {
-			sdFile.write((image[i] & 0xFF00) >> 8);
-			sdFile.write(image[i] & 0x00FF);
+	//Lepton2 in the native size or every second pixel, Lepton3 all pixels
+	uint16_t width = 160, height = 120, lineStep = 160;
+	byte pixelStep = 1;
+	if (imageNative) {
+		width = 80;
+		height = 60;
+		lineStep = 80;
+	}
+	else if (leptonVersion != leptonVersion_3_Shutter) {
+		width = 80;
+		height = 60;
+		pixelStep = 2;
+		lineStep = 320;
+	}
+
+	//Compress the frame, encoded once straight into the sector buffer
+	rawWriteByte(RAWCODEC_MARKER);
+	if (width == 160)
+		rawWriteByte(RAWCODEC_LEPTON3 | RAWCODEC_POINTS);
+	else
+		rawWriteByte(RAWCODEC_POINTS);
+	rawCodedCount = 0;
+	rawCodedLimit = (width * height * 2) - 2;
+	rawCodec.encode(image, width, height, pixelStep, lineStep, rawWriteCoded);
+
+	//Not smaller, go back to the start and write the raw values instead
+	if (rawCodedCount >= rawCodedLimit) {
+		//The sectors already sent can not be taken back, continue through the file system
+		videoStreamStop();
+		rawFile->seekSet(framePos);
+		rawBufferPos = 0;
+		if (!isImage)
+			rawWriteLong(frameTime);
+		for (int line = 0; line < height; line++) {
+			for (int column = 0; column < width; column++)
+				rawWriteWord(image[(line * lineStep) + (column * pixelStep)]);
 		}
 	}
 
 	//Write min and max
-	sdFile.write((minTemp & 0xFF00) >> 8);
-	sdFile.write(minTemp & 0x00FF);
-	sdFile.write((maxTemp & 0xFF00) >> 8);
-	sdFile.write(maxTemp & 0x00FF);
+	rawWriteWord(minTemp);
+	rawWriteWord(maxTemp);
 
 	//Write the object temp 
 	uint8_t farray[4];
 	floatToBytes(farray, mlx90614Temp);
 	for (int i = 0; i < 4; i++)
-		sdFile.write(farray[i]);
+		rawWriteByte(farray[i]);
 
 	//Write the color scheme
-	sdFile.write(colorScheme);
+	rawWriteByte(colorScheme);
 	//Write the temperature format
-	sdFile.write(tempFormat);
+	rawWriteByte(tempFormat);
 	//Write the show spot attribute
-	sdFile.write(spotEnabled);
+	rawWriteByte(spotEnabled);
 	//Write the show colorbar attribute
 	if (calStatus == cal_warmup)
-		sdFile.write((byte)0);
+		rawWriteByte(0);
 	else
-		sdFile.write(colorbarEnabled);
+		rawWriteByte(colorbarEnabled);
 	//Write the temperature points enabled attribute
 	if (calStatus == cal_warmup)
-		sdFile.write((byte)0);
+		rawWriteByte(0);
 	else
-		sdFile.write(pointsEnabled);
+		rawWriteByte(pointsEnabled);
 
 	//Write calibration offset
 	floatToBytes(farray, (float)calOffset);
 	for (int i = 0; i < 4; i++)
-		sdFile.write(farray[i]);
+		rawWriteByte(farray[i]);
 	//Write calibration slope
 	floatToBytes(farray, (float)calSlope);
 	for (int i = 0; i < 4; i++)
-		sdFile.write(farray[i]);
+		rawWriteByte(farray[i]);
 
 	//Write temperature points
-	for (int i = 0; i < 192; i++) {
-		sdFile.write((showTemp[i] & 0xFF00) >> 8);
-		sdFile.write(showTemp[i] & 0x00FF);
+	for (int i = 0; i < 192; i++)
+		rawWriteWord(showTemp[i]);
+
+	//Video frame, fill up the last sector
+	if (!isImage) {
+		while (rawBufferPos != 0)
+			rawWriteByte(0);
+		videoStreamStop();
+		//Update the frame number from time to time, in case the recording is interrupted
+		if (((framesCaptured + 1) % video_syncFrames) == 0)
+			writeVideoHeader(framesCaptured + 1, 0);
+		//Save the allocation once the file grows over the preallocated block
+		if (videoFile.fileSize() > videoPrealloc)
+			videoFile.sync();
+		rawFile = &sdFile;
+	}
+	//Image, write the last sector and close the file
+	else {
+		rawWriteFlush();
+		catalogAdd(name, catalogType_raw, sdFile.fileSize());
+		sdFile.close();
 	}
 
-	//Close the file
-	sdFile.close();
 	//Switch Clock back to Standard
 	endAltClockline();
 }
 
 /* Save a screenshot to the sd card */
 void saveScreenshot() {
+		uint16_t line[320];
 		Serial.println("Saving Screenshot..");
 		//Switch Clock to Alternative
 		startAltClockline(true);
@@ -470,7 +761,7 @@ void saveScreenshot() {
 			if (!sd.exists(filename))
 				break;
 		}
-		sdFile.open(filename, O_RDWR | O_CREAT | O_AT_END);
+		sdFile.open(filename, O_RDWR | O_CREAT | O_TRUNC);
 		//320 x 240 bitmap header
 		const char bmp_header[66] = { 0x42, 0x4D, 0x36, 0x58, 0x02, 0x00, 0x00,
 			0x00, 0x00, 0x00, 0x42, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00,
@@ -479,28 +770,19 @@ void saveScreenshot() {
 			0x00, 0xC4, 0x0E, 0x00, 0x00, 0xC4, 0x0E, 0x00, 0x00, 0x00,
 			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x00,
 			0x00, 0xE0, 0x07, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 };
-		//Write the BMP header
-		for (int i = 0; i < 66; i++) {
-			char ch = bmp_header[i];
-			sdFile.write((uint8_t*)&ch, 1);
-		}
-		//Allocate space for sd buffer
-		unsigned short pixel;
-		//Save 320*60 pixels from the screen at one time
-		for (int i = 3; i >= 0; i--) {
-			endAltClockline();
-			//Read pixels from the display
-			display.readScreen(i, image);
-			startAltClockline();
-			for (byte y = 0; y < 60; y++) {
-				//Write them into the sd buffer
-				for (uint16_t x = 0; x < 320; x++) {
-					pixel = image[((59 - y) * 320) + x];
-					sdFile.write(pixel & 0x00FF);
-					sdFile.write((pixel & 0xFF00) >> 8);
-				}
+		//Write the BMP header through the sector buffer
+		rawBufferPos = 0;
+		for (int i = 0; i < 66; i++)
+			rawWriteByte(bmp_header[i]);
+		//Save the lines of the framebuffer, bottom up
+		for (int y = 239; y >= 0; y--) {
+			framebufferLine(line, y / 2);
+			for (uint16_t x = 0; x < 320; x++) {
+				rawWriteByte(line[x] & 0x00FF);
+				rawWriteByte((line[x] & 0xFF00) >> 8);
 			}
 		}
+		rawWriteFlush();
 		//Close file
 		sdFile.close();
 		//End SD Transmission
@@ -16,9 +16,12 @@
 /* Includes */
 
 #include "Calibration.h"
+#include "Pipeline.h"
 #include "Create.h"
+#include "Catalog.h"
 #include "Load.h"
 #include "Save.h"
+#include "Benchmark.h"
 
 /* Methods*/
 